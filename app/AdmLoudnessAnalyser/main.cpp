@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include <admLoudnessAnalyser/AdmLoudnessAnalyser.hpp>
+#include <loudnessCommon/Trace.hpp>
 #include <adm_engine/parser.hpp>
 
 void displayUsage(const char* application) {
@@ -16,6 +17,12 @@ void displayUsage(const char* application) {
     std::cout << "      -d --display         Display loudness analyse values" << std::endl;
     std::cout << "      -e ELEMENT_ID        Select the AudioProgramme to be rendered and analysed (and corrected) by ELEMENT_ID" << std::endl;
     std::cout << "      -g ELEMENT_ID=GAIN   GAIN value (in dB) to apply to ADM element defined by its ELEMENT_ID at ADM rendering" << std::endl;
+    std::cout << "      --start=SECONDS      Process the input from this time (the input file is sought to it)" << std::endl;
+    std::cout << "      --end=SECONDS        Process the input up to this time (the output files and loudness values cover the range only)" << std::endl;
+    std::cout << "      --threads=N          Process the audio programmes in N threads (0: a thread per audio programme, 1 by default)" << std::endl;
+    std::cout << "      --stats              Print the time spent in each stage of the processing" << std::endl;
+    std::cout << "      --trace=FILE         Write the timeline of the processing to FILE in the Chrome trace event format" << std::endl;
+    std::cout << "                           (or set the LOUDNESS_TRACE environment variable to FILE)" << std::endl;
     std::cout << std::endl;
     std::cout << "    Analyse mode options:" << std::endl;
     std::cout << "      -o OUTPUT            Output file with updated ADM with loudness values" << std::endl;
@@ -55,6 +62,11 @@ int main(int argc, char const *argv[])
     bool displayValues = false;
     bool enableCorrection = false;
     bool enableLimiter = false;
+    bool showStats = false;
+    int nbThreads = 1;
+    double startTime = 0; // range to process, in seconds
+    double endTime = 0;
+    std::string traceFilename;
 
     if(Loudness::admanalyser::AdmLoudnessAnalyser::getPathType(inputFilePath) != Loudness::admanalyser::EPathType::file) {
         std::cerr << "Invalid argument: specified input file '" << inputFilePath << "' does not exist or is not a regular file." << std::endl << std::endl;
@@ -73,6 +85,16 @@ int main(int argc, char const *argv[])
                 displayValues = true;
             } else if(arg == "-g") {
                 elementGainsPairs.push_back(argv[++i]);
+            } else if(arg.compare(0, 10, "--threads=") == 0) {
+                nbThreads = std::atoi(arg.substr(10).c_str());
+            } else if(arg.compare(0, 8, "--start=") == 0) {
+                startTime = std::atof(arg.substr(8).c_str());
+            } else if(arg.compare(0, 6, "--end=") == 0) {
+                endTime = std::atof(arg.substr(6).c_str());
+            } else if(arg == "--stats") {
+                showStats = true;
+            } else if(arg.compare(0, 8, "--trace=") == 0) {
+                traceFilename = arg.substr(8);
             } else {
                 std::cerr << "Invalid argument: " << arg << std::endl;
                 displayUsage(argv[0]);
@@ -95,6 +117,16 @@ int main(int argc, char const *argv[])
                 enableLimiter = true;
             } else if(arg == "-g") {
                 elementGainsPairs.push_back(argv[++i]);
+            } else if(arg.compare(0, 10, "--threads=") == 0) {
+                nbThreads = std::atoi(arg.substr(10).c_str());
+            } else if(arg.compare(0, 8, "--start=") == 0) {
+                startTime = std::atof(arg.substr(8).c_str());
+            } else if(arg.compare(0, 6, "--end=") == 0) {
+                endTime = std::atof(arg.substr(6).c_str());
+            } else if(arg == "--stats") {
+                showStats = true;
+            } else if(arg.compare(0, 8, "--trace=") == 0) {
+                traceFilename = arg.substr(8);
             } else {
                 std::cerr << "Invalid argument: " << arg << std::endl;
                 displayUsage(argv[0]);
@@ -114,6 +146,12 @@ int main(int argc, char const *argv[])
         return 1;
     }
 
+    if(endTime != 0 && endTime <= startTime) {
+        std::cerr << "Error: the end of the range must be after its start." << std::endl << std::endl;
+        displayUsage(argv[0]);
+        return 1;
+    }
+
     std::cout << "Input file:            " << inputFilePath << std::endl;
     std::cout << "Output path:           " << (outputPath.empty()? "-" : outputPath) << std::endl;
     std::cout << "ADM element to render: " << (elementIdToRender.empty()? "-" : elementIdToRender) << std::endl;
@@ -126,9 +164,17 @@ int main(int argc, char const *argv[])
     const std::string outputLayout("0+2+0");
     std::map<std::string, float> elementGains = parseElementGains(elementGainsPairs);
 
+    Loudness::common::TraceSession traceSession(traceFilename);
     try {
         Loudness::admanalyser::AdmLoudnessAnalyser analyser(inputFilePath, outputLayout, elementGains, outputPath, elementIdToRender);
+        analyser.setNbThreads(nbThreads < 0 ? 1 : nbThreads);
+        if(startTime > 0 || endTime > 0) {
+            analyser.setRange(startTime * analyser.getSampleRate(), endTime * analyser.getSampleRate());
+        }
         analyser.process(displayValues, enableCorrection, enableLimiter);
+        if(showStats) {
+            analyser.getStats().print(std::cout);
+        }
     } catch(const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
@@ -3,30 +3,45 @@
 #include <cstring>
 #include <vector>
 #include <ctime>
+#include <cstdlib>
 
 #include <loudnessAnalyser/LoudnessAnalyser.hpp>
 
 #include <loudnessIO/ProcessFile.hpp>
 #include <loudnessIO/SoundFile.hpp>
 #include <loudnessTools/WriteXml.hpp>
+#include <loudnessCommon/Trace.hpp>
 
 bool showProgress = false;
 bool showResults = false;
+bool progressInSeconds = false; // duration of a stream is unknown
 
 void progress(int p)
 {
     if(showProgress)
-        std::cout << "[" << p << "%]\r" << std::flush;
+        std::cout << "[" << p << (progressInSeconds ? "s" : "%") << "]\r" << std::flush;
 }
 
 int main(int argc, char** argv)
 {
     bool validToProcess = false;
     bool showTime = false;
+    bool showStats = false;
+    std::string traceFilename;
     bool enableOptimization = true;
+    bool lazyTruePeak = false;
+    double startTime = 0; // range to process, in seconds
+    double endTime = 0;
+    Loudness::analyser::ETruePeakFilter truePeakFilter = Loudness::analyser::eTruePeakFilterLegacy;
     std::vector<int> standards;
     std::vector<std::string> filenames;
 
+    // headerless PCM input
+    bool rawInput = false;
+    int rawSampleRate = 48000;
+    int rawNbChannels = 2;
+    int rawBitDepth = Loudness::io::SoundFile::eBitDepth16Bits;
+
     time_t start, end;
 
     for(int i = 1; i < argc; i++)
@@ -45,6 +60,52 @@ int main(int argc, char** argv)
         {
             showTime = true;
         }
+        if(strcmp(argv[i], "--stats") == 0)
+        {
+            showStats = true;
+        }
+        if(strncmp(argv[i], "--trace=", 8) == 0)
+        {
+            traceFilename = argv[i] + 8;
+            continue;
+        }
+        if(strncmp(argv[i], "--true-peak=", 12) == 0)
+        {
+            const char* filterName = argv[i] + 12;
+            if(strcmp(filterName, "legacy") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterLegacy;
+            else if(strcmp(filterName, "strict2x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterStrict2x;
+            else if(strcmp(filterName, "strict4x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterStrict4x;
+            else if(strcmp(filterName, "strict8x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterStrict8x;
+            else if(strcmp(filterName, "fast2x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterFast2x;
+            else if(strcmp(filterName, "fast4x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterFast4x;
+            else if(strcmp(filterName, "fast8x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterFast8x;
+            else
+            {
+                std::cout << "Error: unknown true peak filter specified in command line" << std::endl;
+                return -100;
+            }
+        }
+        if(strcmp(argv[i], "--lazy-true-peak") == 0)
+        {
+            lazyTruePeak = true;
+        }
+        if(strncmp(argv[i], "--start=", 8) == 0)
+        {
+            startTime = atof(argv[i] + 8);
+            continue;
+        }
+        if(strncmp(argv[i], "--end=", 6) == 0)
+        {
+            endTime = atof(argv[i] + 6);
+            continue;
+        }
         if(strcmp(argv[i], "--disable-optimization") == 0)
         {
             enableOptimization = false;
@@ -75,31 +136,89 @@ int main(int argc, char** argv)
                 }
             }
         }
-        if(standards.empty())
+        if(strcmp(argv[i], "--raw") == 0)
+        {
+            rawInput = true;
+        }
+        if(strncmp(argv[i], "--sample-rate=", 14) == 0)
+        {
+            rawSampleRate = atoi(argv[i] + 14);
+        }
+        if(strncmp(argv[i], "--channels=", 11) == 0)
+        {
+            rawNbChannels = atoi(argv[i] + 11);
+        }
+        if(strncmp(argv[i], "--bit-depth=", 12) == 0)
+        {
+            if(strcmp(argv[i], "--bit-depth=16") == 0)
+                rawBitDepth = Loudness::io::SoundFile::eBitDepth16Bits;
+            else if(strcmp(argv[i], "--bit-depth=24") == 0)
+                rawBitDepth = Loudness::io::SoundFile::eBitDepth24Bits;
+            else if(strcmp(argv[i], "--bit-depth=32") == 0)
+                rawBitDepth = Loudness::io::SoundFile::eBitDepth32Bits;
+            else if(strcmp(argv[i], "--bit-depth=float") == 0)
+                rawBitDepth = Loudness::io::SoundFile::eBitDepthFloat;
+            else
+            {
+                std::cout << "Error: unknown bit depth specified in command line" << std::endl;
+                return -100;
+            }
+        }
+        if(strcmp(argv[i], "-") == 0)
         {
-            standards.push_back(1); // default standard : EBU R128
+            filenames.push_back(argv[i]);
+            validToProcess = true;
+            continue;
         }
         std::string ext(argv[i]);
         ext.erase(0, ext.length() - 5);
         std::string ext4 = ext;
         ext4.erase(0, 1);
-        if(strcmp(ext.c_str(), ".aiff") == 0 || strcmp(ext4.c_str(), ".aif") == 0 || strcmp(ext4.c_str(), ".wav") == 0)
+        if(strcmp(ext.c_str(), ".aiff") == 0 || strcmp(ext4.c_str(), ".aif") == 0 || strcmp(ext4.c_str(), ".wav") == 0 ||
+           strcmp(ext4.c_str(), ".pcm") == 0 || strcmp(ext4.c_str(), ".raw") == 0)
         {
             filenames.push_back(argv[i]);
             validToProcess = true;
         }
     }
+    if(endTime != 0 && endTime <= startTime)
+    {
+        std::cout << "Error: the end of the range must be after its start" << std::endl;
+        return -100;
+    }
+    if(standards.empty())
+    {
+        standards.push_back(1); // default standard : EBU R128
+    }
+    if(rawInput && filenames.empty())
+    {
+        // headerless PCM is read from the standard input by default
+        filenames.push_back("-");
+        validToProcess = true;
+    }
     if(validToProcess)
     {
+        Loudness::common::TraceSession traceSession(traceFilename);
         for(size_t i = 0; i < filenames.size(); i++)
         {
+            const bool isStdin = filenames.at(i) == "-";
+            if(isStdin && standards.size() > 1)
+            {
+                // the standard input cannot be rewound to be analysed again
+                std::cout << "Error: only one standard can be validated when reading the standard input" << std::endl;
+                return -100;
+            }
+
             std::cout << filenames.at(i) << std::endl;
 
-            std::string filename(filenames.at(i));
-            if(filename.at(filename.length() - 4) == '.')
-                filename.erase(filename.length() - 4, 4);
-            else if(filename.at(filename.length() - 5) == '.')
-                filename.erase(filename.length() - 5, 5);
+            std::string filename(isStdin ? "stdin" : filenames.at(i));
+            if(!isStdin)
+            {
+                if(filename.at(filename.length() - 4) == '.')
+                    filename.erase(filename.length() - 4, 4);
+                else if(filename.at(filename.length() - 5) == '.')
+                    filename.erase(filename.length() - 5, 5);
+            }
 
             filename.append("_PLoud.xml");
             Loudness::tools::WriteXml writerXml(filename, filenames.at(i));
@@ -113,17 +232,33 @@ int main(int argc, char** argv)
                                                                 : Loudness::analyser::LoudnessLevels::Loudness_ATSC_A85();
 
                 Loudness::analyser::LoudnessAnalyser loudness(levels);
-                if(!audioFile.open_read(filenames.at(i).c_str()))
+                loudness.enableLazyTruePeak(lazyTruePeak);
+                loudness.setTruePeakFilter(truePeakFilter);
+                const int error = rawInput ? audioFile.open_read_raw(filenames.at(i).c_str(), rawSampleRate,
+                                                                     rawNbChannels, rawBitDepth)
+                                           : audioFile.open_read(filenames.at(i).c_str());
+                if(!error)
                 {
                     time(&start);
                     Loudness::io::AnalyseFile analyser(loudness, audioFile);
                     analyser.enableOptimization(enableOptimization);
+                    if(startTime > 0 || endTime > 0)
+                        analyser.setRange(startTime * audioFile.getSampleRate(), endTime * audioFile.getSampleRate());
+                    progressInSeconds = !analyser.hasKnownDuration();
                     analyser(progress);
                     time(&end);
                     if(showResults)
                         loudness.printPloudValues();
                     audioFile.close();
-                    writerXml.writeResults("unknown", loudness);
+                    {
+                        Loudness::common::ScopedTrace trace("xml");
+                        writerXml.writeResults("unknown", loudness);
+                    }
+                    if(showStats)
+                    {
+                        loudness.printStats();
+                        analyser.printStats();
+                    }
                     double dif = difftime(end, start);
                     if(showTime)
                         std::cout << "processing time: " << dif << " seconds." << std::endl;
@@ -136,12 +271,29 @@ int main(int argc, char** argv)
         std::cout << "Loudness Analyser" << std::endl;
         std::cout << "Author: Marc-Antoine ARNAUD" << std::endl << std::endl;
         std::cout << "Common usage :" << std::endl;
-        std::cout << "\tloudness-analyser [options] filename.ext" << std::endl << std::endl;
+        std::cout << "\tloudness-analyser [options] filename.ext" << std::endl;
+        std::cout << "\tcat filename.wav | loudness-analyser [options] -" << std::endl << std::endl;
         std::cout << "Options :" << std::endl;
         std::cout << "\t--standard=ebu/cst/atsc : select one standard to validate the Loudness" << std::endl;
         std::cout << "\t\t\tebu:  EBU R 128 (default)" << std::endl;
         std::cout << "\t\t\tcst:  CST RT 017" << std::endl;
         std::cout << "\t\t\tatsc: ATSC A/85" << std::endl;
+        std::cout << "\t- : read the audio from the standard input (results in stdin_PLoud.xml)" << std::endl;
+        std::cout << "\t--raw : input is headerless little endian PCM (read from the standard input if no file given)"
+                  << std::endl;
+        std::cout << "\t--sample-rate=N : sample rate of the raw input (default 48000)" << std::endl;
+        std::cout << "\t--channels=N : number of channels of the raw input (default 2)" << std::endl;
+        std::cout << "\t--bit-depth=16/24/32/float : sample format of the raw input (default 16)" << std::endl;
+        std::cout << "\t--start=SECONDS / --end=SECONDS : analyse only this range of the input (seek to the start)"
+                  << std::endl;
+        std::cout << "\t--lazy-true-peak : oversample only the blocks which can raise the TruePeak of the program"
+                  << std::endl;
+        std::cout << "\t--true-peak=legacy/strict2x/strict4x/strict8x/fast2x/fast4x/fast8x : oversampling filter"
+                  << std::endl;
+        std::cout << "\t--stats : print the time spent in each stage of the analysis and of the I/O" << std::endl;
+        std::cout << "\t--trace=file.json : write the timeline of the processing in the Chrome trace event format"
+                  << std::endl;
+        std::cout << "\t\t\t(or set the LOUDNESS_TRACE environment variable to the file)" << std::endl;
         return -1;
     }
     return 0;
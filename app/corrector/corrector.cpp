@@ -4,11 +4,13 @@
 #include <vector>
 #include <cmath>
 #include <sstream>
+#include <cstdlib>
 
 #include <loudnessAnalyser/LoudnessAnalyser.hpp>
 #include <loudnessIO/ProcessFile.hpp>
 #include <loudnessIO/SoundFile.hpp>
 #include <loudnessTools/WriteXml.hpp>
+#include <loudnessCommon/Trace.hpp>
 
 bool showProgress = false;
 bool showResults = false;
@@ -25,7 +27,13 @@ int main(int argc, char** argv)
     bool analyseAfterCorrecting = false;
     bool enableLimiter = false;
     bool printLength = false;
+    bool showStats = false;
+    std::string traceFilename;
     bool enableOptimization = true;
+    bool lazyTruePeak = false;
+    double startTime = 0; // range to process, in seconds
+    double endTime = 0;
+    Loudness::analyser::ETruePeakFilter truePeakFilter = Loudness::analyser::eTruePeakFilterLegacy;
     int standard = 1;
     std::vector<std::string> filenames;
 
@@ -53,6 +61,15 @@ int main(int argc, char** argv)
         {
             enableLimiter = true;
         }
+        if(strcmp(argv[i], "--stats") == 0)
+        {
+            showStats = true;
+        }
+        if(strncmp(argv[i], "--trace=", 8) == 0)
+        {
+            traceFilename = argv[i] + 8;
+            continue;
+        }
         if(strcmp(argv[i], "--length") == 0)
         {
             printLength = true;
@@ -77,6 +94,43 @@ int main(int argc, char** argv)
                 lookaheadTime = t;
             }
         }
+        if(strncmp(argv[i], "--true-peak=", 12) == 0)
+        {
+            const char* filterName = argv[i] + 12;
+            if(strcmp(filterName, "legacy") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterLegacy;
+            else if(strcmp(filterName, "strict2x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterStrict2x;
+            else if(strcmp(filterName, "strict4x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterStrict4x;
+            else if(strcmp(filterName, "strict8x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterStrict8x;
+            else if(strcmp(filterName, "fast2x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterFast2x;
+            else if(strcmp(filterName, "fast4x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterFast4x;
+            else if(strcmp(filterName, "fast8x") == 0)
+                truePeakFilter = Loudness::analyser::eTruePeakFilterFast8x;
+            else
+            {
+                std::cout << "Error: unknown true peak filter specified in command line" << std::endl;
+                return -100;
+            }
+        }
+        if(strcmp(argv[i], "--lazy-true-peak") == 0)
+        {
+            lazyTruePeak = true;
+        }
+        if(strncmp(argv[i], "--start=", 8) == 0)
+        {
+            startTime = atof(argv[i] + 8);
+            continue;
+        }
+        if(strncmp(argv[i], "--end=", 6) == 0)
+        {
+            endTime = atof(argv[i] + 6);
+            continue;
+        }
         if(strcmp(argv[i], "--disable-optimization") == 0)
         {
             enableOptimization = false;
@@ -117,8 +171,14 @@ int main(int argc, char** argv)
             validToProcess = true;
         }
     }
+    if(endTime != 0 && endTime <= startTime)
+    {
+        std::cout << "Error: the end of the range must be after its start" << std::endl;
+        return -100;
+    }
     if(validToProcess)
     {
+        Loudness::common::TraceSession traceSession(traceFilename);
         for(size_t i = 0; i < filenames.size(); i++)
         {
             std::cout << filenames.at(i) << std::flush;
@@ -136,14 +196,22 @@ int main(int argc, char** argv)
                                               : Loudness::analyser::LoudnessLevels::Loudness_ATSC_A85();
 
             Loudness::analyser::LoudnessAnalyser loudness(levels);
+            loudness.enableLazyTruePeak(lazyTruePeak);
+            loudness.setTruePeakFilter(truePeakFilter);
             if(!audioFile.open_read(filenames.at(i).c_str()))
             {
                 if(printLength)
                     std::cout << "\t length = " << (float)audioFile.getNbSamples() / audioFile.getSampleRate() << "\t"
                               << std::flush;
 
+                const size_t firstSample = startTime * audioFile.getSampleRate();
+                const size_t lastSample = endTime * audioFile.getSampleRate();
+                const bool hasRange = startTime > 0 || endTime > 0;
+
                 Loudness::io::AnalyseFile analyser(loudness, audioFile);
                 analyser.enableOptimization(enableOptimization);
+                if(hasRange)
+                    analyser.setRange(firstSample, lastSample);
                 analyser(progress);
 
                 if(showResults)
@@ -152,7 +220,16 @@ int main(int argc, char** argv)
                 std::string xmlFile = filename;
                 xmlFile.append("_measured.xml");
                 Loudness::tools::WriteXml writerXml(xmlFile, filenames.at(i));
-                writerXml.writeResults("unknown", loudness);
+                {
+                    Loudness::common::ScopedTrace trace("xml");
+                    writerXml.writeResults("unknown", loudness);
+                }
+                if(showStats)
+                {
+                    std::cout << std::endl;
+                    loudness.printStats();
+                    analyser.printStats();
+                }
 
                 std::string outputFilename = filenames.at(i);
                 int insertPoint = 4;
@@ -162,6 +239,8 @@ int main(int argc, char** argv)
 
                 Loudness::io::SoundFile outputAudioFile;
                 Loudness::analyser::LoudnessAnalyser loudnessAfterCorrection(levels);
+                loudnessAfterCorrection.enableLazyTruePeak(lazyTruePeak);
+                loudnessAfterCorrection.setTruePeakFilter(truePeakFilter);
 
                 if(!outputAudioFile.open_write(outputFilename.c_str(), audioFile.getAudioCodec(), audioFile.getBitDepth(),
                                                audioFile.getSampleRate(), audioFile.getNbChannels()))
@@ -174,12 +253,20 @@ int main(int argc, char** argv)
                     {
                         Loudness::io::CorrectFileWithCompressor corrector(loudnessAfterCorrection, audioFile,
                                                                           outputAudioFile, gain, lookaheadTime, threshold);
+                        if(hasRange)
+                            corrector.setRange(firstSample, lastSample);
                         corrector(progress);
+                        if(showStats)
+                            corrector.printStats();
                     }
                     else
                     {
                         Loudness::io::CorrectFile corrector(loudnessAfterCorrection, audioFile, outputAudioFile, gain);
+                        if(hasRange)
+                            corrector.setRange(firstSample, lastSample);
                         corrector(progress);
+                        if(showStats)
+                            corrector.printStats();
                     }
                     outputAudioFile.close();
                 }
@@ -196,7 +283,12 @@ int main(int argc, char** argv)
                 xmlFileCorrected.append("_corrected_measured.xml");
 
                 Loudness::tools::WriteXml writerXmlCorrected(xmlFileCorrected, outputFilename);
-                writerXmlCorrected.writeResults("unknown", loudnessAfterCorrection);
+                {
+                    Loudness::common::ScopedTrace trace("xml");
+                    writerXmlCorrected.writeResults("unknown", loudnessAfterCorrection);
+                }
+                if(showStats)
+                    loudnessAfterCorrection.printStats();
                 result = loudnessAfterCorrection.isValidProgram();
             }
             std::cout << std::endl;
@@ -219,6 +311,18 @@ int main(int argc, char** argv)
         std::cout << "\t--analyse-corrected: analyse corrected file after writing" << std::endl;
         std::cout << "\t--enable-limiter: activate brick wall look ahead limiter" << std::endl;
         std::cout << "\t--lookahead-time: specify the look-ahead time for the limiter (default is 60ms)" << std::endl;
+        std::cout << "\t--start=SECONDS / --end=SECONDS: correct only this range of the input (the output file contains "
+                     "only the range)"
+                  << std::endl;
+        std::cout << "\t--lazy-true-peak: oversample only the blocks which can raise the TruePeak of the program"
+                  << std::endl;
+        std::cout << "\t--true-peak=legacy/strict2x/strict4x/strict8x/fast2x/fast4x/fast8x: oversampling filter"
+                  << std::endl;
+        std::cout << "\t--stats: print the time spent in each stage of the analysis, of the correction and of the I/O"
+                  << std::endl;
+        std::cout << "\t--trace=file.json: write the timeline of the processing in the Chrome trace event format"
+                  << std::endl;
+        std::cout << "\t\t\t(or set the LOUDNESS_TRACE environment variable to the file)" << std::endl;
         return -1;
     }
 
@@ -6,6 +6,7 @@
 #include <stdexcept>
 
 #include <AvTranscoder/encoder/AudioEncoder.hpp>
+#include <AvTranscoder/file/InputFile.hpp>
 #include <AvTranscoder/file/OutputFile.hpp>
 #include <AvTranscoder/transform/AudioTransform.hpp>
 
@@ -14,6 +15,22 @@ const float MAX_VALUE_24_BITS = 8388607.0;
 const std::string CODEC_NAME_24_BITS = "pcm_s24le";
 const std::string SAMPLE_FORMAT_24_BITS = "s32";
 
+/**
+ * @return whether the codec stores the samples in a format of the analyser
+ */
+static bool getPcmFormat(const std::string& codecName, Loudness::analyser::EPcmFormat& format)
+{
+    if(codecName == "pcm_s16le")
+        format = Loudness::analyser::ePcmFormatS16LE;
+    else if(codecName == "pcm_s24le")
+        format = Loudness::analyser::ePcmFormatS24LE;
+    else if(codecName == "pcm_s32le")
+        format = Loudness::analyser::ePcmFormatS32LE;
+    else
+        return false;
+    return true;
+}
+
 void AvSoundFile::printProgress()
 {
     const int p = (float)_cumulOfSamplesAnalysed / _totalNbSamplesToAnalyse * 100;
@@ -25,7 +42,7 @@ void AvSoundFile::printProgress()
         *_outputStream << p;
     }
     // print progression to console
-    else
+    else if(_printProgress)
         *_outputStream << "[" << std::setw(3) << p << "%]\r" << std::flush;
 }
 
@@ -35,17 +52,91 @@ bool AvSoundFile::isEndOfAnalysis()
 }
 
 AvSoundFile::AvSoundFile(const std::vector<avtranscoder::InputStreamDesc>& arrayToAnalyse)
-    : _nbChannelsToAnalyse(0)
+    : AvSoundFile(std::vector<ProgrammeGroup>(1, ProgrammeGroup("", arrayToAnalyse)))
+{
+}
+
+AvSoundFile::AvSoundFile(const std::vector<ProgrammeGroup>& groups)
+    : _programmes()
     , _totalNbSamplesToAnalyse(0)
     , _cumulOfSamplesAnalysed(0)
     , _inputNbChannels()
     , _inputSampleRate()
+    , _inputNbSamples()
+    , _inputStreams()
     , _audioReader()
+    , _decodeAheadReader()
+    , _decodedFrames()
     , _outputStream(&std::cout)
     , _progressionFileName()
+    , _printProgress(true)
     , _forceDurationToAnalyse(0)
+    , _startTime(0)
+    , _pcmPassthrough(false)
+    , _pcmFormat(Loudness::analyser::ePcmFormatS16LE)
+    , _decodeStats()
+    , _gainStats()
+    , _encodeStats()
+    , _writeStats()
+    , _spillStats()
+{
+    if(groups.empty())
+        throw std::runtime_error("The given audio configuration has no audio stream to analyse.");
+
+    createAudioReaders(groups);
+    for(std::vector<ProgrammeGroup>::const_iterator it = groups.begin(); it != groups.end(); ++it)
+        addProgramme(*it);
+    _totalNbSamplesToAnalyse = getTotalNbSamplesToAnalyse();
+
+    // Check if the samples can be analysed as they are stored
+    if(_programmes.size() == 1 && _audioReader.size() == 1)
+    {
+        const avtranscoder::AudioProperties* audioProperties = _audioReader.at(0)->getSourceAudioProperties();
+        const std::vector<std::pair<size_t, size_t> >& channels = _programmes.at(0).channels;
+        const size_t nbSelectedChannels = _inputStreams.at(0)._channelIndexArray.size();
+        bool allChannelsInOrder = channels.size() == audioProperties->getNbChannels();
+        for(size_t i = 0; i < channels.size() && allChannelsInOrder; ++i)
+        {
+            const size_t decodedChannel = channels.at(i).second;
+            const size_t inputChannel =
+                nbSelectedChannels ? (size_t)_inputStreams.at(0)._channelIndexArray.at(decodedChannel) : decodedChannel;
+            if(inputChannel != i)
+                allChannelsInOrder = false;
+        }
+        _pcmPassthrough = allChannelsInOrder && getPcmFormat(audioProperties->getCodecName(), _pcmFormat);
+    }
+}
+
+void AvSoundFile::createAudioReaders(const std::vector<ProgrammeGroup>& groups)
 {
-    for(std::vector<avtranscoder::InputStreamDesc>::const_iterator it = arrayToAnalyse.begin(); it != arrayToAnalyse.end(); ++it)
+    // Merge the channels of the groups for each stream
+    for(std::vector<ProgrammeGroup>::const_iterator group = groups.begin(); group != groups.end(); ++group)
+    {
+        for(std::vector<avtranscoder::InputStreamDesc>::const_iterator it = group->streams.begin(); it != group->streams.end(); ++it)
+        {
+            std::vector<avtranscoder::InputStreamDesc>::iterator inputStream = _inputStreams.begin();
+            while(inputStream != _inputStreams.end() &&
+                  (inputStream->_filename != it->_filename || inputStream->_streamIndex != it->_streamIndex))
+                ++inputStream;
+
+            if(inputStream == _inputStreams.end())
+                _inputStreams.push_back(*it);
+            // an empty list of channels decodes all of them
+            else if(it->_channelIndexArray.empty())
+                inputStream->_channelIndexArray.clear();
+            else if(!inputStream->_channelIndexArray.empty())
+            {
+                for(size_t i = 0; i < it->_channelIndexArray.size(); ++i)
+                {
+                    if(std::find(inputStream->_channelIndexArray.begin(), inputStream->_channelIndexArray.end(),
+                                 it->_channelIndexArray.at(i)) == inputStream->_channelIndexArray.end())
+                        inputStream->_channelIndexArray.push_back(it->_channelIndexArray.at(i));
+                }
+            }
+        }
+    }
+
+    for(std::vector<avtranscoder::InputStreamDesc>::const_iterator it = _inputStreams.begin(); it != _inputStreams.end(); ++it)
     {
         // Create reader to convert to float planar
         avtranscoder::AudioReader* reader = new avtranscoder::AudioReader(*it);
@@ -55,35 +146,78 @@ AvSoundFile::AvSoundFile(const std::vector<avtranscoder::InputStreamDesc>& array
         // Get data from audio stream
         const avtranscoder::AudioProperties* audioProperties = reader->getSourceAudioProperties();
         const int nbChannels = it->_channelIndexArray.empty() ? audioProperties->getNbChannels() : it->_channelIndexArray.size();
-        _inputNbChannels.push_back(std::min(nbChannels, 5)); // skip LRE
+        _inputNbChannels.push_back(0); // updated by the groups
         const size_t sampleRate = audioProperties->getSampleRate();
         _inputSampleRate.push_back(sampleRate);
-        _totalNbSamplesToAnalyse += audioProperties->getNbSamples() * nbChannels;
+        _inputNbSamples.push_back(audioProperties->getNbSamples());
 
         // Update output of reader
         reader->updateOutput(sampleRate, nbChannels, "fltp");
     }
+    _decodedFrames.resize(_audioReader.size(), NULL);
+}
+
+void AvSoundFile::addProgramme(const ProgrammeGroup& group)
+{
+    if(group.streams.empty())
+        throw std::runtime_error("The given audio configuration has no audio stream to analyse in group " + group.name + ".");
+
+    Programme programme;
+    programme.name = group.name;
+    programme.nbSamples = 0;
+    programme.spillCache = NULL;
+
+    std::vector<size_t> streamNbChannels;
+    std::vector<size_t> streamSampleRate;
+    for(std::vector<avtranscoder::InputStreamDesc>::const_iterator it = group.streams.begin(); it != group.streams.end(); ++it)
+    {
+        size_t readerIndex = 0;
+        while(_inputStreams.at(readerIndex)._filename != it->_filename || _inputStreams.at(readerIndex)._streamIndex != it->_streamIndex)
+            ++readerIndex;
+        const avtranscoder::InputStreamDesc& inputStream = _inputStreams.at(readerIndex);
+
+        const size_t nbChannels = it->_channelIndexArray.empty() ? _audioReader.at(readerIndex)->getSourceAudioProperties()->getNbChannels()
+                                                                 : it->_channelIndexArray.size();
+        streamNbChannels.push_back(std::min(nbChannels, (size_t)5)); // skip LRE
+        streamSampleRate.push_back(_inputSampleRate.at(readerIndex));
+
+        for(size_t i = 0; i < streamNbChannels.back(); ++i)
+        {
+            // position of the channel in the decoded frames of the reader
+            size_t decodedChannel = i;
+            if(!it->_channelIndexArray.empty())
+            {
+                decodedChannel = it->_channelIndexArray.at(i);
+                if(!inputStream._channelIndexArray.empty())
+                    decodedChannel = std::find(inputStream._channelIndexArray.begin(), inputStream._channelIndexArray.end(),
+                                               it->_channelIndexArray.at(i)) - inputStream._channelIndexArray.begin();
+            }
+            programme.channels.push_back(std::make_pair(readerIndex, decodedChannel));
+            _inputNbChannels.at(readerIndex) = std::max(_inputNbChannels.at(readerIndex), decodedChannel + 1);
+        }
+    }
 
     // Check the given configuration
     bool nbChannelsAreEqual = true;
     bool sampleRateAreEqual = true;
-    const size_t nbChannels = _inputNbChannels.at(0);
-    const size_t sampleRate = _inputSampleRate.at(0);
-    for(size_t i = 1; i < _inputNbChannels.size(); i++)
+    for(size_t i = 1; i < streamNbChannels.size(); i++)
     {
         // check number of channels
-        if(_inputNbChannels.at(i) != nbChannels)
+        if(streamNbChannels.at(i) != streamNbChannels.at(0))
             nbChannelsAreEqual = false;
         // check sample rate
-        if(_inputSampleRate.at(i) != sampleRate)
+        if(streamSampleRate.at(i) != streamSampleRate.at(0))
             sampleRateAreEqual = false;
     }
 
     if(!nbChannelsAreEqual || !sampleRateAreEqual)
     {
         std::string msg = "The given audio configuration isn't supported by the application.\n";
-        msg += "Only audio stream with same sample rate and same number of channels are supported.\n";
-        msg += "Error:\n";
+        msg += "Only audio stream with same sample rate and same number of channels are supported in a group.\n";
+        msg += "Error";
+        if(!group.name.empty())
+            msg += " in group " + group.name;
+        msg += ":\n";
         if(nbChannelsAreEqual == false)
             msg += "- Number of channels are not equals\n";
         if(sampleRateAreEqual == false)
@@ -93,15 +227,16 @@ AvSoundFile::AvSoundFile(const std::vector<avtranscoder::InputStreamDesc>& array
     }
 
     // Get number of channels to analyse
-    int totalInputNbChannels = 0;
-    for(size_t i = 0; i < _inputNbChannels.size(); ++i)
-        totalInputNbChannels += _inputNbChannels.at(i);
-    _nbChannelsToAnalyse = std::min(totalInputNbChannels, 5); // skip LRE
+    if(programme.channels.size() > 5)
+        programme.channels.resize(5); // skip LRE
+    programme.audioBuffer.resize(programme.channels.size(), NULL);
+    _programmes.push_back(programme);
 }
 
 AvSoundFile::~AvSoundFile()
 {
-	for(std::vector<avtranscoder::AudioReader*>::iterator it = _audioReader.begin(); it != _audioReader.end(); ++it)
+    stopDecoding();
+    for(std::vector<avtranscoder::AudioReader*>::iterator it = _audioReader.begin(); it != _audioReader.end(); ++it)
     {
         delete(*it);
     }
@@ -110,42 +245,84 @@ AvSoundFile::~AvSoundFile()
 size_t AvSoundFile::getTotalNbSamplesToAnalyse()
 {
     size_t newTotalNbSamplesToAnalyse = 0;
-    for(size_t i = 0; i < _inputSampleRate.size(); i++)
+    for(std::vector<Programme>::const_iterator programme = _programmes.begin(); programme != _programmes.end(); ++programme)
     {
-        newTotalNbSamplesToAnalyse += _forceDurationToAnalyse * _inputSampleRate.at(i) * _inputNbChannels.at(i);
+        for(size_t i = 0; i < programme->channels.size(); i++)
+        {
+            const size_t readerIndex = programme->channels.at(i).first;
+            const size_t nbSamplesToSkip = _startTime * _inputSampleRate.at(readerIndex);
+            size_t nbSamples =
+                _inputNbSamples.at(readerIndex) > nbSamplesToSkip ? _inputNbSamples.at(readerIndex) - nbSamplesToSkip : 0;
+            if(_forceDurationToAnalyse)
+                nbSamples = _forceDurationToAnalyse * _inputSampleRate.at(readerIndex);
+            newTotalNbSamplesToAnalyse += nbSamples;
+        }
     }
     return newTotalNbSamplesToAnalyse;
 }
 
-bool AvSoundFile::fillAudioBuffer(float** audioBuffer, size_t& nbSamplesRead, size_t& nbInputChannelAdded)
+void AvSoundFile::startDecoding()
 {
     for(size_t fileIndex = 0; fileIndex < _audioReader.size(); ++fileIndex)
     {
-        avtranscoder::IFrame* dstFrame = _audioReader.at(fileIndex)->readNextFrame();
+        const size_t nbSamplesToSkip = _startTime * _inputSampleRate.at(fileIndex);
+        const size_t nbSamplesToRead = _forceDurationToAnalyse * _inputSampleRate.at(fileIndex);
+        _decodeAheadReader.push_back(new DecodeAheadReader(*_audioReader.at(fileIndex), _inputNbChannels.at(fileIndex),
+                                                           nbSamplesToSkip, nbSamplesToRead));
+    }
+}
+
+void AvSoundFile::stopDecoding()
+{
+    for(std::vector<DecodeAheadReader*>::iterator it = _decodeAheadReader.begin(); it != _decodeAheadReader.end(); ++it)
+    {
+        delete(*it);
+    }
+    _decodeAheadReader.clear();
+}
+
+bool AvSoundFile::fillAudioBuffers(size_t& nbSamplesRead)
+{
+    Loudness::common::ScopedStageTimer timer(_decodeStats, 0, "decode");
+    for(size_t fileIndex = 0; fileIndex < _decodeAheadReader.size(); ++fileIndex)
+    {
+        _decodedFrames.at(fileIndex) = _decodeAheadReader.at(fileIndex)->readNextFrame();
 
         // empty frame: go to the end of process
-        if(dstFrame == NULL)
+        if(_decodedFrames.at(fileIndex) == NULL)
         {
             return false;
         }
+    }
 
-        size_t inputChannel = 0;
-        for(size_t channelToAdd = nbInputChannelAdded;
-            channelToAdd < nbInputChannelAdded + _inputNbChannels.at(fileIndex); ++channelToAdd)
+    // the groups reference the channels of the decoded frames
+    for(std::vector<Programme>::iterator programme = _programmes.begin(); programme != _programmes.end(); ++programme)
+    {
+        for(size_t channel = 0; channel < programme->channels.size(); ++channel)
         {
-            audioBuffer[channelToAdd] = (float*)(dstFrame->getData()[inputChannel]);
-            ++inputChannel;
-            nbSamplesRead += dstFrame->getAVFrame().nb_samples;
+            DecodedFrame* decodedFrame = _decodedFrames.at(programme->channels.at(channel).first);
+            programme->audioBuffer.at(channel) = decodedFrame->channels.at(programme->channels.at(channel).second).data();
         }
-        nbInputChannelAdded += _inputNbChannels.at(fileIndex);
+        programme->nbSamples = _decodedFrames.at(programme->channels.at(0).first)->nbSamples;
+        nbSamplesRead += programme->nbSamples * programme->channels.size();
     }
+    timer.setItems(nbSamplesRead);
     return true;
 }
 
-void AvSoundFile::analyse(Loudness::analyser::LoudnessAnalyser& analyser)
+void AvSoundFile::analyse(Loudness::analyser::LoudnessAnalyser& analyser, Loudness::common::ProgressToken* token)
 {
+    analyse(std::vector<Loudness::analyser::LoudnessAnalyser*>(1, &analyser), token);
+}
+
+void AvSoundFile::analyse(const std::vector<Loudness::analyser::LoudnessAnalyser*>& analysers,
+                          Loudness::common::ProgressToken* token)
+{
+    if(analysers.size() != _programmes.size())
+        throw std::runtime_error("A loudness analyser is expected for each group of the audio configuration.");
+
     // update number of samples to analyse
-    if(_forceDurationToAnalyse)
+    if(_forceDurationToAnalyse || _startTime)
     {
         // set total number of samples to analyse
         _totalNbSamplesToAnalyse = getTotalNbSamplesToAnalyse();
@@ -160,41 +337,136 @@ void AvSoundFile::analyse(Loudness::analyser::LoudnessAnalyser& analyser)
     }
 
     // init
-    analyser.initAndStart(_nbChannelsToAnalyse, _inputSampleRate.at(0));
-
-    // Create planar buffer of float data
-    float** audioBuffer = new float*[_nbChannelsToAnalyse];
+    for(size_t i = 0; i < _programmes.size(); ++i)
+    {
+        const Programme& programme = _programmes.at(i);
+        analysers.at(i)->initAndStart(programme.channels.size(), _inputSampleRate.at(programme.channels.at(0).first));
+    }
 
     // Analyze audio streams
-    while(!isEndOfAnalysis())
+    // the generator completes a forced duration after the end of the input with silence: only the decoded frames can
+    // be analysed
+    const bool rangeInInput =
+        !_forceDurationToAnalyse || (_startTime + _forceDurationToAnalyse) * _inputSampleRate.at(0) <= _inputNbSamples.at(0);
+    if(_pcmPassthrough && rangeInInput)
     {
-        // Decode audio streams
-        size_t nbSamplesRead = 0;
-        size_t nbInputChannelAdded = 0;
-        if(!fillAudioBuffer(audioBuffer, nbSamplesRead, nbInputChannelAdded))
-            break;
-
-        // Analyse loudness
-        const size_t nbSamplesInOneFrame = nbSamplesRead / nbInputChannelAdded;
-        analyser.processSamples(audioBuffer, nbSamplesInOneFrame);
+        analysePcmPackets(*analysers.at(0), token);
+    }
+    else
+    {
+        startDecoding();
+        while(!isEndOfAnalysis() && !(token && token->isCancelled()))
+        {
+            // Decode audio streams
+            size_t nbSamplesRead = 0;
+            if(!fillAudioBuffers(nbSamplesRead))
+                break;
+
+            for(size_t i = 0; i < _programmes.size(); ++i)
+            {
+                Programme& programme = _programmes.at(i);
+
+                // Keep the decoded samples for the correction
+                if(programme.spillCache)
+                {
+                    Loudness::common::ScopedStageTimer timer(_spillStats, programme.nbSamples * programme.channels.size(), "spill");
+                    programme.spillCache->writeFrame(programme.audioBuffer.data(), programme.channels.size(), programme.nbSamples);
+                }
+
+                // Analyse loudness
+                analysers.at(i)->processSamples(programme.audioBuffer.data(), programme.nbSamples);
+            }
+
+            // Progress
+            _cumulOfSamplesAnalysed += nbSamplesRead;
+            printProgress();
+            if(token)
+                token->setProgress((float)_cumulOfSamplesAnalysed / _totalNbSamplesToAnalyse * 100);
+        }
+        stopDecoding();
+    }
 
-        // Progress
-        _cumulOfSamplesAnalysed += nbSamplesRead;
-        printProgress();
+    for(std::vector<Programme>::iterator programme = _programmes.begin(); programme != _programmes.end(); ++programme)
+    {
+        if(programme->spillCache && !(token && token->isCancelled()))
+        {
+            Loudness::common::ScopedStageTimer timer(_spillStats, 0, "spill");
+            programme->spillCache->endOfWrite();
+        }
     }
 
     // Close progression file
     if(! _progressionFileName.empty())
         outputFile.close();
+}
+
+void AvSoundFile::analysePcmPackets(Loudness::analyser::LoudnessAnalyser& analyser, Loudness::common::ProgressToken* token)
+{
+    const avtranscoder::InputStreamDesc& inputStream = _inputStreams.at(0);
+    avtranscoder::InputFile inputFile(inputStream._filename);
+    SpillCache* spillCache = _programmes.at(0).spillCache;
+    const size_t nbChannelsToAnalyse = _programmes.at(0).channels.size();
+
+    // the demuxers split the PCM streams on whole samples of all channels
+    const size_t nbBytesPerSample = _pcmFormat * nbChannelsToAnalyse;
+    size_t nbSamplesToSkip = _startTime * _inputSampleRate.at(0);
+    size_t nbSamplesToRead = _forceDurationToAnalyse * _inputSampleRate.at(0);
+    while(!isEndOfAnalysis() && !(token && token->isCancelled()))
+    {
+        // Demux audio stream
+        avtranscoder::CodedData packet;
+        size_t nbSamplesInPacket = 0;
+        {
+            Loudness::common::ScopedStageTimer timer(_decodeStats, 0, "decode");
+            if(!inputFile.readNextPacket(packet, inputStream._streamIndex))
+                break;
+            nbSamplesInPacket = packet.getSize() / nbBytesPerSample;
+            timer.setItems(nbSamplesInPacket * nbChannelsToAnalyse);
+        }
+
+        // Drop the samples before the start time
+        const size_t nbSamplesSkipped = std::min(nbSamplesToSkip, nbSamplesInPacket);
+        const unsigned char* samples = packet.getData() + nbSamplesSkipped * nbBytesPerSample;
+        nbSamplesToSkip -= nbSamplesSkipped;
+        nbSamplesInPacket -= nbSamplesSkipped;
+        if(nbSamplesInPacket == 0)
+            continue;
+
+        // Drop the samples after the end of the forced duration
+        if(_forceDurationToAnalyse)
+        {
+            nbSamplesInPacket = std::min(nbSamplesInPacket, nbSamplesToRead);
+            nbSamplesToRead -= nbSamplesInPacket;
+        }
 
-    // free audio buffer
-    delete[] audioBuffer;
+        // Keep the samples for the correction
+        if(spillCache)
+        {
+            Loudness::common::ScopedStageTimer timer(_spillStats, nbSamplesInPacket * nbChannelsToAnalyse, "spill");
+            spillCache->writePcmFrame(samples, nbChannelsToAnalyse, nbSamplesInPacket, _pcmFormat);
+        }
+
+        // Analyse loudness
+        analyser.processInterleavedPcmSamples(samples, nbSamplesInPacket, _pcmFormat);
+
+        // Progress
+        _cumulOfSamplesAnalysed += nbSamplesInPacket * nbChannelsToAnalyse;
+        printProgress();
+        if(token)
+            token->setProgress((float)_cumulOfSamplesAnalysed / _totalNbSamplesToAnalyse * 100);
+    }
 }
 
-void AvSoundFile::correct(Loudness::analyser::LoudnessAnalyser& analyser, const std::string& outputFilePath, const float gain)
+void AvSoundFile::correct(Loudness::analyser::LoudnessAnalyser& analyser, const std::string& outputFilePath, const float gain,
+                          Loudness::common::ProgressToken* token)
 {
+    if(_programmes.size() != 1)
+        throw std::runtime_error("The correction writes the streams of a single group of the audio configuration.");
+    Programme& programme = _programmes.at(0);
+    const size_t nbChannelsToAnalyse = programme.channels.size();
+
     // update number of samples to analyse
-    if(_forceDurationToAnalyse)
+    if(_forceDurationToAnalyse || _startTime)
     {
         // set total number of samples to analyse
         _totalNbSamplesToAnalyse = getTotalNbSamplesToAnalyse();
@@ -209,17 +481,10 @@ void AvSoundFile::correct(Loudness::analyser::LoudnessAnalyser& analyser, const
     }
 
     // init
-    analyser.initAndStart(_nbChannelsToAnalyse, _inputSampleRate.at(0));
-
-    // Create planar buffer of float data
-    float** audioBuffer = new float*[_nbChannelsToAnalyse];
+    analyser.initAndStart(nbChannelsToAnalyse, _inputSampleRate.at(programme.channels.at(0).first));
 
     // Initialize output encoder
-    int totalInputNbChannels = 0;
-    for(size_t i = 0; i < _inputNbChannels.size(); ++i)
-        totalInputNbChannels += _inputNbChannels.at(i);
-
-    avtranscoder::AudioFrameDesc outputAudioFrameDesc(_audioReader.at(0)->getOutputSampleRate(), totalInputNbChannels, SAMPLE_FORMAT_24_BITS);
+    avtranscoder::AudioFrameDesc outputAudioFrameDesc(_audioReader.at(0)->getOutputSampleRate(), nbChannelsToAnalyse, SAMPLE_FORMAT_24_BITS);
     avtranscoder::AudioEncoder* encoder = new avtranscoder::AudioEncoder(CODEC_NAME_24_BITS);
     encoder->setupAudioEncoder(outputAudioFrameDesc);
 
@@ -227,30 +492,55 @@ void AvSoundFile::correct(Loudness::analyser::LoudnessAnalyser& analyser, const
     outputFile->addAudioStream(encoder->getAudioCodec());
     outputFile->beginWrap();
 
+    // read the samples of the analysis if they are in the cache
+    const bool readSpillCache = programme.spillCache && programme.spillCache->isAvailable();
+    if(!readSpillCache)
+        startDecoding();
+
     // reset counters
     _cumulOfSamplesAnalysed = 0;
 
-    while(!isEndOfAnalysis())
+    // interlaced PCM of the corrected frame, reused by all the frames: it grows only when a frame is bigger
+    std::vector<unsigned char> rawData;
+
+    float** audioBuffer = programme.audioBuffer.data();
+    while(!isEndOfAnalysis() && !(token && token->isCancelled()))
     {
         // Decode audio streams
         size_t nbSamplesRead = 0;
-        size_t nbInputChannelAdded = 0;
-        if(!fillAudioBuffer(audioBuffer, nbSamplesRead, nbInputChannelAdded))
+        if(readSpillCache)
+        {
+            Loudness::common::ScopedStageTimer timer(_spillStats, 0, "spill");
+            if(!programme.spillCache->readFrame(audioBuffer, programme.nbSamples))
+                break;
+            nbSamplesRead = programme.nbSamples * nbChannelsToAnalyse;
+            timer.setItems(nbSamplesRead);
+        }
+        else if(!fillAudioBuffers(nbSamplesRead))
             break;
 
         // Apply gain
-        const size_t nbSamplesInOneFrame = nbSamplesRead / nbInputChannelAdded;
-        applyGain(audioBuffer, nbSamplesInOneFrame, gain);
+        const size_t nbSamplesInOneFrame = programme.nbSamples;
+        {
+            Loudness::common::ScopedStageTimer timer(_gainStats, nbSamplesRead, "gain");
+            applyGain(audioBuffer, nbChannelsToAnalyse, nbSamplesInOneFrame, gain);
+        }
 
         // Convert corrected frame
         const size_t rawDataSize = nbSamplesRead * NB_OF_BYTES_24_BITS;
-        unsigned char* rawData = new unsigned char[rawDataSize];
-        encodePlanarSamplesToInterlacedPcm(audioBuffer, rawData, nbSamplesInOneFrame);
+        rawData.resize(rawDataSize);
+        {
+            Loudness::common::ScopedStageTimer timer(_encodeStats, nbSamplesRead, "encode");
+            encodePlanarSamplesToInterlacedPcm(audioBuffer, rawData.data(), nbChannelsToAnalyse, nbSamplesInOneFrame);
+        }
 
-        // Write corrected frame
-        avtranscoder::CodedData data;
-        data.copyData(rawData, rawDataSize);
-        outputFile->wrap(data, 0);
+        // Write corrected frame: the packet references the encoded samples, without copy
+        {
+            Loudness::common::ScopedStageTimer timer(_writeStats, nbSamplesRead, "write");
+            avtranscoder::CodedData data;
+            data.refData(rawData.data(), rawDataSize);
+            outputFile->wrap(data, 0);
+        }
 
         // Analyse loudness
         analyser.processSamples(audioBuffer, nbSamplesInOneFrame);
@@ -258,10 +548,11 @@ void AvSoundFile::correct(Loudness::analyser::LoudnessAnalyser& analyser, const
         // Progress
         _cumulOfSamplesAnalysed += nbSamplesRead;
         printProgress();
-
-        delete rawData;
+        if(token)
+            token->setProgress((float)_cumulOfSamplesAnalysed / _totalNbSamplesToAnalyse * 100);
     }
 
+    stopDecoding();
     outputFile->endWrap();
 
     delete encoder;
@@ -270,9 +561,6 @@ void AvSoundFile::correct(Loudness::analyser::LoudnessAnalyser& analyser, const
     // Close progression file
     if(! _progressionFileName.empty())
         progressOutputFile.close();
-
-    // free audio buffer
-    delete[] audioBuffer;
 }
 
 float AvSoundFile::clipSample(const float value)
@@ -286,10 +574,13 @@ float AvSoundFile::clipSample(const float value)
     return value;
 }
 
-void AvSoundFile::applyGain(float** audioBuffer, const size_t numberOfSamplesPerChannel, const float gain)
+void AvSoundFile::applyGain(float** audioBuffer, const size_t nbChannels, const size_t numberOfSamplesPerChannel, const float gain)
 {
-    for(size_t channel = 0; channel < _nbChannelsToAnalyse; channel++)
+    for(size_t channel = 0; channel < nbChannels; channel++)
     {
+        // a channel listed twice references the same decoded samples
+        if(std::find(audioBuffer, audioBuffer + channel, audioBuffer[channel]) != audioBuffer + channel)
+            continue;
         for(size_t sample = 0; sample < numberOfSamplesPerChannel; sample++)
         {
             audioBuffer[channel][sample] = audioBuffer[channel][sample] * gain;
@@ -297,12 +588,13 @@ void AvSoundFile::applyGain(float** audioBuffer, const size_t numberOfSamplesPer
     }
 }
 
-void AvSoundFile::encodePlanarSamplesToInterlacedPcm(float** planarBuffer, unsigned char* interlacedBuffer, const size_t numberOfSamplesPerChannel)
+void AvSoundFile::encodePlanarSamplesToInterlacedPcm(float** planarBuffer, unsigned char* interlacedBuffer, const size_t nbChannels,
+                                                     const size_t numberOfSamplesPerChannel)
 {
     size_t sampleCounter = 0;
     for(size_t sample = 0; sample < numberOfSamplesPerChannel; sample++)
     {
-        for(size_t channel = 0; channel < _nbChannelsToAnalyse; channel++)
+        for(size_t channel = 0; channel < nbChannels; channel++)
         {
             const size_t offset = sampleCounter++ * NB_OF_BYTES_24_BITS;
             const float sampleValueClipped = clipSample(planarBuffer[channel][sample]);
@@ -320,12 +612,19 @@ void AvSoundFile::setDurationToAnalyse(const float durationToAnalyse)
         _forceDurationToAnalyse = durationToAnalyse;
 }
 
-size_t AvSoundFile::getNbChannelsToAnalyse() const
+void AvSoundFile::setStartTime(const float startTime)
 {
-    size_t nbChannelsToAnalyse = 0;
-    for(std::vector<size_t>::const_iterator it = _inputNbChannels.begin(); it != _inputNbChannels.end(); ++it)
-    {
-        nbChannelsToAnalyse += *it;
-    }
-    return nbChannelsToAnalyse;
+    if(startTime > 0)
+        _startTime = startTime;
+}
+
+void AvSoundFile::printStats(std::ostream& os) const
+{
+    os << "I/O stats:" << std::endl;
+    Loudness::common::printStageStats(os, "decode", _decodeStats);
+    Loudness::common::printStageStats(os, "gain", _gainStats);
+    Loudness::common::printStageStats(os, "encode", _encodeStats);
+    Loudness::common::printStageStats(os, "write", _writeStats);
+    Loudness::common::printStageStats(os, "spill", _spillStats);
+    os << std::endl;
 }
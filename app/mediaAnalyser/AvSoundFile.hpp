@@ -2,24 +2,63 @@
 #define AVSOUNDFILE_HPP
 
 #include <loudnessAnalyser/LoudnessAnalyser.hpp>
+#include <loudnessCommon/Instrumentation.hpp>
+#include <loudnessCommon/ProgressToken.hpp>
+
+#include "DecodeAheadReader.hpp"
+#include "SpillCache.hpp"
 
 #include <AvTranscoder/reader/AudioReader.hpp>
 
 #include <vector>
+#include <string>
 #include <utility>
 #include <iostream>
 
+/**
+ * @brief Audio elements analysed together as one programme.
+ */
+struct ProgrammeGroup
+{
+    ProgrammeGroup(const std::string& name, const std::vector<avtranscoder::InputStreamDesc>& streams)
+        : name(name)
+        , streams(streams)
+    {
+    }
+
+    std::string name; ///< empty for the programme of a configuration without groups
+    std::vector<avtranscoder::InputStreamDesc> streams;
+};
+
 /**
  * @brief Read and analyse the given audio elements.
+ * Each group of elements is analysed as a programme, from a single decode of the streams shared by the groups.
  */
 class AvSoundFile
 {
 public:
     AvSoundFile(const std::vector<avtranscoder::InputStreamDesc>& arrayToAnalyse);
+    AvSoundFile(const std::vector<ProgrammeGroup>& groups);
     ~AvSoundFile();
 
-    void analyse(Loudness::analyser::LoudnessAnalyser& analyser);
-    void correct(Loudness::analyser::LoudnessAnalyser& analyser, const std::string& outputFilePath, const float gain);
+    /**
+     * @brief Analyse the single group of elements.
+     * @param token if given, receives the progress and stops the process at its next frame when it is cancelled
+     */
+    void analyse(Loudness::analyser::LoudnessAnalyser& analyser, Loudness::common::ProgressToken* token = NULL);
+
+    /**
+     * @brief Analyse all the groups of elements in one pass.
+     * @param analysers one for each group, in the order of the groups
+     */
+    void analyse(const std::vector<Loudness::analyser::LoudnessAnalyser*>& analysers,
+                 Loudness::common::ProgressToken* token = NULL);
+
+    /**
+     * @brief Correct the single group of elements.
+     */
+    void correct(Loudness::analyser::LoudnessAnalyser& analyser, const std::string& outputFilePath, const float gain,
+                 Loudness::common::ProgressToken* token = NULL);
 
     /**
      * @brief Set the output filename of the progress file.
@@ -27,15 +66,64 @@ public:
      */
     void setProgressionFile(const std::string& progressionFileName) { _progressionFileName = progressionFileName; }
 
+    /**
+     * @brief Print the progress to the console when there is no progress file (true by default).
+     */
+    void setPrintProgress(const bool printProgress) { _printProgress = printProgress; }
+
     /**
      * @brief Force the analysis to be on a specific duration (in seconds)
      * @note By default we use the duration of the input.
      */
     void setDurationToAnalyse(const float durationToAnalyse);
 
-    size_t getNbChannelsToAnalyse() const;
+    /**
+     * @brief Start the analysis at a specific time (in seconds): the forced duration is counted from it.
+     * @note The inputs are decoded from their beginning, the samples before the start are dropped.
+     */
+    void setStartTime(const float startTime);
+
+    /**
+     * @brief Set a cache of the decoded samples: filled by analyse, and read by correct instead of decoding the inputs
+     * if it is available.
+     * @note The cache is shared by the AvSoundFile of the analysis and the one of the correction.
+     * @param groupIndex the group of elements written to the cache
+     */
+    void setSpillCache(SpillCache* spillCache, const size_t groupIndex = 0) { _programmes.at(groupIndex).spillCache = spillCache; }
+
+    size_t getNbGroups() const { return _programmes.size(); }
+    size_t getNbChannelsToAnalyse(const size_t groupIndex = 0) const { return _programmes.at(groupIndex).channels.size(); }
+
+    /**
+     * @brief Print the time spent to decode, correct, encode and write the audio streams, and to write and read the spill cache.
+     */
+    void printStats(std::ostream& os) const;
 
 private:
+    /**
+     * @brief Channels of a group of elements, and their samples in the current frame.
+     */
+    struct Programme
+    {
+        std::string name;
+        /// index of the audio reader and channel in its decoded frames, of each channel to analyse
+        std::vector<std::pair<size_t, size_t> > channels;
+        std::vector<float*> audioBuffer; ///< planar samples of the channels
+        size_t nbSamples;                ///< per channel in the audio buffer
+        SpillCache* spillCache;
+    };
+
+    /**
+     * @brief Create an audio reader for each stream of the groups: a stream of several groups is decoded once,
+     * with the channels of all of them.
+     */
+    void createAudioReaders(const std::vector<ProgrammeGroup>& groups);
+
+    /**
+     * @brief Find the channels of the group in the audio readers, and check their configuration.
+     */
+    void addProgramme(const ProgrammeGroup& group);
+
     /**
      * @brief Print progress of analysis
      * If _progressionFileName si not empty, print to file _progressionFile
@@ -50,22 +138,38 @@ private:
 
     /**
      * @brief Compute the total number of samples to analyse from the several inputs
-     * sample rate, the number of channels and the expected duration.
+     * sample rate, the number of channels of each group, the start time and the expected duration.
      * @return the number of samples to analyse
      */
     size_t getTotalNbSamplesToAnalyse();
 
     /**
-     * @brief Fill input audio buffer with data from audio readers, and increment the
-     * number of read channels and the total number of samples read (every read channels).
-     * @return whether the audiobuffer could be filled
+     * @brief Analyse the packets of an uncompressed stream without decoding them: the interleaved PCM samples
+     * are given to the analyser in their own format.
+     */
+    void analysePcmPackets(Loudness::analyser::LoudnessAnalyser& analyser, Loudness::common::ProgressToken* token);
+
+    /**
+     * @brief Start a decoding thread for each audio reader, from the start time.
+     */
+    void startDecoding();
+
+    /**
+     * @brief Stop the decoding threads, the audio readers can be used again by the calling thread.
+     */
+    void stopDecoding();
+
+    /**
+     * @brief Fill the audio buffer of each group with a frame decoded ahead from audio readers, and increment
+     * the total number of samples read (every channels of every groups).
+     * @return whether the audio buffers could be filled
      */
-    bool fillAudioBuffer(float** audioBuffer, size_t& nbSamplesRead, size_t& nbInputChannelAdded);
+    bool fillAudioBuffers(size_t& nbSamplesRead);
 
     /**
      * @brief Apply gain to specified planar audio buffer samples.
      */
-    void applyGain(float** audioBuffer, const size_t numberOfSamplesPerChannel, const float gain);
+    void applyGain(float** audioBuffer, const size_t nbChannels, const size_t numberOfSamplesPerChannel, const float gain);
 
     /**
      * @brief Clip audio sample value to normalized values [-1.0, 1.0].
@@ -76,29 +180,48 @@ private:
     /**
      * @brief Convert planar audio samples buffer into interlaced PCM values buffer.
      */
-    void encodePlanarSamplesToInterlacedPcm(float** planarBuffer, unsigned char* interlacedBuffer, const size_t numberOfSamplesPerChannel);
+    void encodePlanarSamplesToInterlacedPcm(float** planarBuffer, unsigned char* interlacedBuffer, const size_t nbChannels,
+                                            const size_t numberOfSamplesPerChannel);
 
 private:
     // for loudness analyser
-    size_t _nbChannelsToAnalyse;
+    std::vector<Programme> _programmes;
 
     // for progress
     size_t _totalNbSamplesToAnalyse;
     size_t _cumulOfSamplesAnalysed;
 
     // to check audio before analyse
-    std::vector<size_t> _inputNbChannels;
+    std::vector<size_t> _inputNbChannels; ///< copied from the decoded frames of each reader
     std::vector<size_t> _inputSampleRate;
+    std::vector<size_t> _inputNbSamples;
 
     // for io
+    std::vector<avtranscoder::InputStreamDesc> _inputStreams; ///< decoded by each reader
     std::vector<avtranscoder::AudioReader*> _audioReader;
+    std::vector<DecodeAheadReader*> _decodeAheadReader; ///< decoding threads of the readers, while analysing
+    std::vector<DecodedFrame*> _decodedFrames;          ///< current frame of each reader
 
     // To print the progession to a stream
     std::ostream* _outputStream;
     std::string _progressionFileName;
+    bool _printProgress;
 
     // To force the duration to analyse
     float _forceDurationToAnalyse;
+    float _startTime;
+
+    // a single uncompressed stream, with all its channels analysed in a single group, is analysed without being decoded
+    bool _pcmPassthrough;
+    Loudness::analyser::EPcmFormat _pcmFormat;
+
+    // time spent in each stage (the items are samples of all channels)
+    // the decode stage is the time spent waiting for the decoding threads
+    Loudness::common::StageStats _decodeStats;
+    Loudness::common::StageStats _gainStats;
+    Loudness::common::StageStats _encodeStats;
+    Loudness::common::StageStats _writeStats;
+    Loudness::common::StageStats _spillStats;
 };
 
 #endif
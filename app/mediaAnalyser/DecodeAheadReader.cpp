@@ -0,0 +1,124 @@
+#include "DecodeAheadReader.hpp"
+
+#include <algorithm>
+#include <limits>
+
+DecodeAheadReader::DecodeAheadReader(avtranscoder::AudioReader& reader, const size_t nbChannels, const size_t nbSamplesToSkip,
+                                     const size_t nbSamplesToRead, const size_t queueSize)
+    : _reader(reader)
+    , _nbChannels(nbChannels)
+    , _nbSamplesToSkip(nbSamplesToSkip)
+    , _nbSamplesToRead(nbSamplesToRead ? nbSamplesToRead : std::numeric_limits<size_t>::max())
+    , _queueSize(std::max(queueSize, (size_t)1))
+    , _frames(_queueSize + 1)
+    , _readIndex(0)
+    , _nbDecodedFrames(0)
+    , _endOfStream(false)
+    , _stopped(false)
+    , _exception()
+{
+    for(size_t i = 0; i < _frames.size(); ++i)
+    {
+        _frames.at(i).channels.resize(_nbChannels);
+        _frames.at(i).nbSamples = 0;
+    }
+    _thread = std::thread(&DecodeAheadReader::decode, this);
+}
+
+DecodeAheadReader::~DecodeAheadReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _frameRead.notify_one();
+    _thread.join();
+}
+
+DecodedFrame* DecodeAheadReader::readNextFrame()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _frameDecoded.wait(lock, [this] { return _nbDecodedFrames > 0 || _endOfStream; });
+    if(_nbDecodedFrames == 0)
+    {
+        if(_exception)
+            std::rethrow_exception(_exception);
+        return NULL;
+    }
+
+    DecodedFrame* frame = &_frames.at(_readIndex);
+    _readIndex = (_readIndex + 1) % _frames.size();
+    _nbDecodedFrames--;
+    lock.unlock();
+    _frameRead.notify_one();
+    return frame;
+}
+
+void DecodeAheadReader::decode()
+{
+    while(true)
+    {
+        // wait for a free frame: at most _queueSize frames ahead, so the frame returned last is not overwritten
+        size_t writeIndex = 0;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _frameRead.wait(lock, [this] { return _stopped || _nbDecodedFrames < _queueSize; });
+            if(_stopped)
+                return;
+            writeIndex = (_readIndex + _nbDecodedFrames) % _frames.size();
+        }
+
+        // decode and copy outside of the lock
+        avtranscoder::IFrame* srcFrame = NULL;
+        try
+        {
+            // drop the frames before the first sample, and stop after the last sample
+            size_t firstSample = 0;
+            size_t nbSamplesInFrame = 0;
+            while(nbSamplesInFrame == 0 && _nbSamplesToRead > 0)
+            {
+                srcFrame = _reader.readNextFrame();
+                if(srcFrame == NULL)
+                    break;
+                nbSamplesInFrame = srcFrame->getAVFrame().nb_samples;
+                firstSample = std::min(_nbSamplesToSkip, nbSamplesInFrame);
+                _nbSamplesToSkip -= firstSample;
+                nbSamplesInFrame -= firstSample;
+            }
+            if(nbSamplesInFrame == 0)
+                srcFrame = NULL;
+
+            if(srcFrame != NULL)
+            {
+                // the frame which reaches the last sample is cut
+                nbSamplesInFrame = std::min(nbSamplesInFrame, _nbSamplesToRead);
+                _nbSamplesToRead -= nbSamplesInFrame;
+
+                DecodedFrame& dstFrame = _frames.at(writeIndex);
+                dstFrame.nbSamples = nbSamplesInFrame;
+                for(size_t channel = 0; channel < _nbChannels; ++channel)
+                {
+                    const float* samples = (const float*)(srcFrame->getData()[channel]) + firstSample;
+                    dstFrame.channels.at(channel).assign(samples, samples + dstFrame.nbSamples);
+                }
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _exception = std::current_exception();
+            srcFrame = NULL;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(srcFrame == NULL)
+                _endOfStream = true;
+            else
+                _nbDecodedFrames++;
+        }
+        _frameDecoded.notify_one();
+        if(srcFrame == NULL)
+            return;
+    }
+}
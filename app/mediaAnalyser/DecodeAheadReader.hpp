@@ -0,0 +1,79 @@
+#ifndef DECODEAHEADREADER_HPP
+#define DECODEAHEADREADER_HPP
+
+#include <AvTranscoder/reader/AudioReader.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Planar float samples of a decoded frame.
+ */
+struct DecodedFrame
+{
+    std::vector<std::vector<float> > channels;
+    size_t nbSamples; ///< per channel
+};
+
+/**
+ * @brief Decode an audio stream ahead of its analysis, in its own thread.
+ * The decoded frames are copied into a bounded queue of recycled frames: the decoding thread waits when the queue is full.
+ * The reader must not be used by another thread while this object exists.
+ */
+class DecodeAheadReader
+{
+public:
+    /**
+     * @param reader which outputs float planar samples
+     * @param nbChannels number of channels to copy from each decoded frame
+     * @param nbSamplesToSkip number of samples (per channel) decoded and dropped before the first frame
+     * @param nbSamplesToRead number of samples (per channel) after the skipped ones: the frame which reaches it is cut,
+     * and the stream ends there (0 to read up to the end of the stream)
+     * @param queueSize maximum number of frames decoded ahead
+     */
+    DecodeAheadReader(avtranscoder::AudioReader& reader, const size_t nbChannels, const size_t nbSamplesToSkip = 0,
+                      const size_t nbSamplesToRead = 0, const size_t queueSize = 4);
+    ~DecodeAheadReader();
+
+    /**
+     * @brief Get the next decoded frame, waiting for it if the decoding thread is late.
+     * The frame is valid until the next call, the caller can modify its samples.
+     * An exception thrown by the decoder is thrown again here.
+     * @return NULL at the end of the stream
+     */
+    DecodedFrame* readNextFrame();
+
+private:
+    DecodeAheadReader(const DecodeAheadReader&);
+    DecodeAheadReader& operator=(const DecodeAheadReader&);
+
+    /**
+     * @brief Body of the decoding thread.
+     */
+    void decode();
+
+private:
+    avtranscoder::AudioReader& _reader;
+    const size_t _nbChannels;
+    size_t _nbSamplesToSkip;
+    size_t _nbSamplesToRead;
+    const size_t _queueSize;
+
+    // ring of _queueSize + 1 frames: the last one returned by readNextFrame is never overwritten
+    std::vector<DecodedFrame> _frames;
+    size_t _readIndex; ///< next frame to return
+    size_t _nbDecodedFrames; ///< in the queue, from _readIndex
+    bool _endOfStream;
+    bool _stopped;
+    std::exception_ptr _exception; ///< thrown by the decoder
+
+    std::mutex _mutex;
+    std::condition_variable _frameDecoded;
+    std::condition_variable _frameRead;
+    std::thread _thread;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "SpillCache.hpp"
+
+#include <loudnessCommon/system.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+
+#ifndef __WINDOWS__
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// written before the samples of each frame
+struct FrameHeader
+{
+    uint32_t nbSamples; ///< per channel
+    uint32_t format;    ///< 0 for planar float samples, else the EPcmFormat of the interleaved samples
+};
+
+const size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+SpillCache::SpillCache(const std::string& directory, const size_t budgetInBytes)
+    : _budget(budgetInBytes)
+    , _fileDescriptor(-1)
+    , _size(0)
+    , _nbChannels(0)
+    , _writeBuffer()
+    , _readable(false)
+    , _dropReason()
+    , _mapping(NULL)
+    , _readOffset(0)
+    , _readChannels()
+{
+#ifndef __WINDOWS__
+    std::string pattern = directory + "/media-loudness-analyser-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    _fileDescriptor = mkstemp(&path[0]);
+    if(_fileDescriptor < 0)
+        throw std::runtime_error("Could not create the spill cache in directory: " + directory);
+    // the file is removed when the descriptor is closed
+    unlink(&path[0]);
+    _writeBuffer.reserve(WRITE_BUFFER_SIZE);
+#else
+    (void)directory;
+    drop("not supported on this platform");
+#endif
+}
+
+SpillCache::~SpillCache()
+{
+#ifndef __WINDOWS__
+    if(_mapping)
+        munmap(_mapping, _size);
+    if(_fileDescriptor >= 0)
+        close(_fileDescriptor);
+#endif
+}
+
+void SpillCache::writeFrame(float** planarData, const size_t nbChannels, const size_t nbSamples)
+{
+    if(_fileDescriptor < 0)
+        return;
+    const FrameHeader header = {(uint32_t)nbSamples, 0};
+    _nbChannels = nbChannels;
+    write(&header, sizeof(header));
+    for(size_t channel = 0; channel < nbChannels; ++channel)
+        write(planarData[channel], nbSamples * sizeof(float));
+}
+
+void SpillCache::writePcmFrame(const unsigned char* interleavedData, const size_t nbChannels, const size_t nbSamples,
+                               const Loudness::analyser::EPcmFormat format)
+{
+    if(_fileDescriptor < 0)
+        return;
+    const FrameHeader header = {(uint32_t)nbSamples, (uint32_t)format};
+    _nbChannels = nbChannels;
+    write(&header, sizeof(header));
+    write(interleavedData, nbSamples * nbChannels * format);
+}
+
+void SpillCache::write(const void* data, const size_t size)
+{
+    if(_fileDescriptor < 0)
+        return;
+    if(_size + size > _budget)
+    {
+        drop("the decoded samples exceed the budget");
+        return;
+    }
+    _size += size;
+
+    if(_writeBuffer.size() + size > WRITE_BUFFER_SIZE)
+    {
+        flush();
+        if(_fileDescriptor < 0)
+            return;
+    }
+    if(size > WRITE_BUFFER_SIZE)
+    {
+        _writeBuffer.assign((const unsigned char*)data, (const unsigned char*)data + size);
+        flush();
+        return;
+    }
+    _writeBuffer.insert(_writeBuffer.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+}
+
+void SpillCache::flush()
+{
+#ifndef __WINDOWS__
+    const unsigned char* data = _writeBuffer.data();
+    size_t remaining = _writeBuffer.size();
+    while(remaining > 0 && _fileDescriptor >= 0)
+    {
+        const ssize_t written = ::write(_fileDescriptor, data, remaining);
+        if(written <= 0)
+        {
+            drop("could not write the scratch file");
+            return;
+        }
+        data += written;
+        remaining -= written;
+    }
+#endif
+    _writeBuffer.clear();
+}
+
+void SpillCache::endOfWrite()
+{
+    flush();
+    if(_fileDescriptor < 0)
+        return;
+#ifndef __WINDOWS__
+    if(_size > 0)
+    {
+        void* mapping = mmap(NULL, _size, PROT_READ, MAP_SHARED, _fileDescriptor, 0);
+        if(mapping == MAP_FAILED)
+        {
+            drop("could not map the scratch file");
+            return;
+        }
+        _mapping = (unsigned char*)mapping;
+        // the frames are read once, in order
+        madvise(_mapping, _size, MADV_SEQUENTIAL);
+    }
+#endif
+    std::vector<unsigned char>().swap(_writeBuffer);
+    _readChannels.resize(_nbChannels);
+    _readable = true;
+}
+
+bool SpillCache::readFrame(float** planarData, size_t& nbSamples)
+{
+    if(!_readable || _readOffset + sizeof(FrameHeader) > _size)
+        return false;
+
+    FrameHeader header;
+    std::memcpy(&header, _mapping + _readOffset, sizeof(header));
+    _readOffset += sizeof(header);
+    nbSamples = header.nbSamples;
+
+    // copy the samples: the correction applies its gain in place
+    for(size_t channel = 0; channel < _nbChannels; ++channel)
+        _readChannels.at(channel).resize(nbSamples);
+    if(header.format == 0)
+    {
+        for(size_t channel = 0; channel < _nbChannels; ++channel)
+        {
+            std::memcpy(_readChannels.at(channel).data(), _mapping + _readOffset, nbSamples * sizeof(float));
+            _readOffset += nbSamples * sizeof(float);
+        }
+    }
+    else
+    {
+        // same values as the analyser: the sample is put in the most significant bytes of a 32 bits integer
+        const size_t nbBytesPerSample = header.format;
+        const float scale = 1.f / 2147483648.f;
+        const unsigned char* data = _mapping + _readOffset;
+        for(size_t sample = 0; sample < nbSamples; ++sample)
+        {
+            for(size_t channel = 0; channel < _nbChannels; ++channel)
+            {
+                uint32_t value = 0;
+                for(size_t byte = 0; byte < nbBytesPerSample; byte++)
+                    value |= (uint32_t)data[byte] << (8 * (4 - nbBytesPerSample + byte));
+                _readChannels.at(channel)[sample] = (int32_t)value * scale;
+                data += nbBytesPerSample;
+            }
+        }
+        _readOffset += nbSamples * _nbChannels * nbBytesPerSample;
+    }
+
+    for(size_t channel = 0; channel < _nbChannels; ++channel)
+        planarData[channel] = _readChannels.at(channel).data();
+    return true;
+}
+
+void SpillCache::drop(const std::string& reason)
+{
+#ifndef __WINDOWS__
+    if(_fileDescriptor >= 0)
+        close(_fileDescriptor);
+#endif
+    _fileDescriptor = -1;
+    _readable = false;
+    std::vector<unsigned char>().swap(_writeBuffer);
+    _dropReason = reason;
+}
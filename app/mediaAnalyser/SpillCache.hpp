@@ -0,0 +1,81 @@
+#ifndef SPILLCACHE_HPP
+#define SPILLCACHE_HPP
+
+#include <loudnessAnalyser/LoudnessAnalyser.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Local copy of the frames of the analysis pass, read again by the correction pass instead of decoding the inputs.
+ * The frames are written to a scratch file (removed at its creation, so it never outlives the process), which is
+ * memory-mapped to be read. If the frames exceed the size budget, the cache is dropped: the correction decodes again.
+ * @note The cache is not available on Windows.
+ */
+class SpillCache
+{
+public:
+    /**
+     * @param directory where the scratch file is created
+     * @param budgetInBytes maximum size of the scratch file
+     */
+    SpillCache(const std::string& directory, const size_t budgetInBytes);
+    ~SpillCache();
+
+    /**
+     * @brief Write a frame of planar float samples.
+     */
+    void writeFrame(float** planarData, const size_t nbChannels, const size_t nbSamples);
+
+    /**
+     * @brief Write a frame of interleaved PCM samples, as they are stored in the input.
+     */
+    void writePcmFrame(const unsigned char* interleavedData, const size_t nbChannels, const size_t nbSamples,
+                       const Loudness::analyser::EPcmFormat format);
+
+    /**
+     * @brief End the write of the frames, and map the scratch file to read them.
+     */
+    void endOfWrite();
+
+    /**
+     * @return whether all the written frames can be read: the write ended within the budget
+     */
+    bool isAvailable() const { return _readable; }
+
+    /**
+     * @return why the cache was dropped, empty if it was not
+     */
+    const std::string& getDropReason() const { return _dropReason; }
+
+    /**
+     * @brief Read the next frame as planar float samples, valid until the next call.
+     * @return false at the end of the frames
+     */
+    bool readFrame(float** planarData, size_t& nbSamples);
+
+    size_t getSize() const { return _size; }
+
+private:
+    SpillCache(const SpillCache&);
+    SpillCache& operator=(const SpillCache&);
+
+    void write(const void* data, const size_t size);
+    void flush();
+    void drop(const std::string& reason);
+
+private:
+    const size_t _budget;
+    int _fileDescriptor;   ///< of the scratch file, -1 if the cache is dropped
+    size_t _size;          ///< of the frames written
+    size_t _nbChannels;
+    std::vector<unsigned char> _writeBuffer;
+    bool _readable;
+    std::string _dropReason;
+
+    unsigned char* _mapping;
+    size_t _readOffset;
+    std::vector<std::vector<float> > _readChannels; ///< planar float samples of the last frame read
+};
+
+#endif
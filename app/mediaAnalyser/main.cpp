@@ -2,21 +2,39 @@
 
 #include <loudnessAnalyser/LoudnessAnalyser.hpp>
 #include <loudnessTools/WriteXml.hpp>
+#include <loudnessCommon/Trace.hpp>
+#include <loudnessCommon/ThreadPool.hpp>
 
 #include <vector>
 #include <utility>
 #include <fstream>
 #include <cmath>
+#include <memory>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
 
-std::vector<avtranscoder::InputStreamDesc> parseConfigFile(const std::string& configFilename)
+std::vector<ProgrammeGroup> parseConfigFile(const std::string& configFilename)
 {
-    std::vector<avtranscoder::InputStreamDesc> result;
+    // the lines before the first group make a group without name
+    std::vector<ProgrammeGroup> groups(1, ProgrammeGroup("", std::vector<avtranscoder::InputStreamDesc>()));
 
     std::ifstream configFile(configFilename.c_str(), std::ifstream::in);
 
     std::string line;
     while(std::getline(configFile, line))
     {
+        // start of a group
+        if(line.size() > 1 && line.at(0) == '[' && line.at(line.size() - 1) == ']')
+        {
+            if(groups.back().streams.empty())
+                groups.pop_back();
+            groups.push_back(ProgrammeGroup(line.substr(1, line.size() - 2), std::vector<avtranscoder::InputStreamDesc>()));
+            continue;
+        }
+
+        std::vector<avtranscoder::InputStreamDesc>& result = groups.back().streams;
         std::istringstream is_line(line);
         std::string filename;
         if(std::getline(is_line, filename, '='))
@@ -51,7 +69,281 @@ std::vector<avtranscoder::InputStreamDesc> parseConfigFile(const std::string& co
 
     configFile.close();
 
-    return result;
+    return groups;
+}
+
+/**
+ * @return the position of the extension in the filename, std::string::npos if it has none
+ */
+size_t findExtension(const std::string& filename)
+{
+    const size_t extension = filename.find_last_of('.');
+    if(extension == std::string::npos || extension < filename.find_last_of('/') + 1)
+        return std::string::npos;
+    return extension;
+}
+
+/**
+ * @return the filename with the suffix added before its extension
+ */
+std::string addSuffix(const std::string& filename, const std::string& suffix)
+{
+    const size_t extension = findExtension(filename);
+    if(extension == std::string::npos)
+        return filename + "_" + suffix;
+    return filename.substr(0, extension) + "_" + suffix + filename.substr(extension);
+}
+
+/**
+ * @return the output file of the correction of a group, suffixed by the group when the configuration has several of them
+ */
+std::string getCorrectionOutputFile(const std::string& outputFile, const std::vector<ProgrammeGroup>& groups, const size_t groupIndex)
+{
+    if(groups.size() == 1)
+        return outputFile;
+
+    std::string suffix = groups.at(groupIndex).name;
+    if(suffix.empty())
+    {
+        std::stringstream ss;
+        ss << groupIndex + 1;
+        suffix = ss.str();
+    }
+    return addSuffix(outputFile, suffix);
+}
+
+/**
+ * @brief Options of the analysis of a configuration file.
+ */
+struct AnalysisSettings
+{
+    AnalysisSettings()
+        : outputXMLReportName("PLoud.xml")
+        , outputProgressionName()
+        , durationToAnalyse(0)
+        , startTime(0)
+        , correction(false)
+        , correctionOutputFile()
+        , spillCacheDirectory()
+        , spillBudgetInMB(2048)
+        , showStats(false)
+        , verbose(true)
+    {
+    }
+
+    std::string outputXMLReportName;
+    std::string outputProgressionName;
+    float durationToAnalyse;
+    float startTime;
+    bool correction;
+    std::string correctionOutputFile;
+    std::string spillCacheDirectory;
+    size_t spillBudgetInMB;
+    bool showStats;
+    bool verbose; ///< print the progress, the results and the stats to the console
+};
+
+/**
+ * @brief Analyse (and correct) the streams of the configuration file, and write the XML report.
+ */
+void analyseConfigFile(const std::string& configFilename, const AnalysisSettings& settings)
+{
+    // Get list of files / streamIndex to analyse, in groups
+    std::vector<ProgrammeGroup> groups = parseConfigFile(configFilename);
+    AvSoundFile soundFile(groups);
+    soundFile.setProgressionFile(settings.outputProgressionName);
+    soundFile.setPrintProgress(settings.verbose);
+    soundFile.setDurationToAnalyse(settings.durationToAnalyse);
+    soundFile.setStartTime(settings.startTime);
+
+    // Keep the decoded samples for the correction
+    std::vector<std::unique_ptr<SpillCache> > spillCaches(groups.size());
+    if(settings.correction && !settings.spillCacheDirectory.empty())
+    {
+        for(size_t i = 0; i < groups.size(); ++i)
+        {
+            spillCaches.at(i).reset(new SpillCache(settings.spillCacheDirectory, settings.spillBudgetInMB * 1024 * 1024));
+            soundFile.setSpillCache(spillCaches.at(i).get(), i);
+        }
+    }
+
+    // Analyse loudness according to EBU R-128, the groups in one pass
+    Loudness::analyser::LoudnessLevels level = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+    std::vector<std::unique_ptr<Loudness::analyser::LoudnessAnalyser> > analysers;
+    std::vector<Loudness::analyser::LoudnessAnalyser*> groupAnalysers;
+    for(size_t i = 0; i < groups.size(); ++i)
+    {
+        analysers.push_back(std::unique_ptr<Loudness::analyser::LoudnessAnalyser>(new Loudness::analyser::LoudnessAnalyser(level)));
+        groupAnalysers.push_back(analysers.back().get());
+    }
+    soundFile.analyse(groupAnalysers);
+
+    // Print analyse
+    if(settings.verbose)
+    {
+        for(size_t i = 0; i < groups.size(); ++i)
+        {
+            if(groups.size() > 1)
+                std::cout << "Group " << groups.at(i).name << ":" << std::endl;
+            analysers.at(i)->printPloudValues();
+            if(settings.showStats)
+                analysers.at(i)->printStats();
+        }
+        if(settings.showStats)
+            soundFile.printStats(std::cout);
+    }
+
+    std::vector<std::string> mediaFilenames;
+    for(size_t i = 0; i < groups.size(); ++i)
+    {
+        for(size_t j = 0; j < groups.at(i).streams.size(); ++j)
+            mediaFilenames.push_back(groups.at(i).streams.at(j)._filename);
+    }
+    Loudness::tools::WriteXml writerXml(settings.outputXMLReportName, mediaFilenames);
+
+    for(size_t i = 0; i < groups.size(); ++i)
+    {
+        const std::vector<avtranscoder::InputStreamDesc>& arrayToAnalyse = groups.at(i).streams;
+        Loudness::analyser::LoudnessAnalyser& analyser = *analysers.at(i);
+        const float gain = analyser.getCorrectionGain();
+
+        if(settings.correction && std::fabs(1.0 - gain) > 0.001)
+        {
+            if(settings.verbose)
+            {
+                if(groups.size() > 1)
+                    std::cout << "Group " << groups.at(i).name << ": ";
+                std::cout << "Correction with gain " << gain << std::endl;
+                if(spillCaches.at(i) && !spillCaches.at(i)->isAvailable())
+                    std::cout << "Spill cache disabled (" << spillCaches.at(i)->getDropReason()
+                              << "): the correction decodes the inputs again." << std::endl;
+            }
+            AvSoundFile correctedSoundFile(arrayToAnalyse);
+            correctedSoundFile.setProgressionFile(settings.outputProgressionName);
+            correctedSoundFile.setPrintProgress(settings.verbose);
+            correctedSoundFile.setDurationToAnalyse(settings.durationToAnalyse);
+            correctedSoundFile.setStartTime(settings.startTime);
+            correctedSoundFile.setSpillCache(spillCaches.at(i).get());
+            correctedSoundFile.correct(analyser, getCorrectionOutputFile(settings.correctionOutputFile, groups, i), gain);
+
+            if(settings.verbose)
+            {
+                analyser.printPloudValues();
+                if(settings.showStats)
+                {
+                    analyser.printStats();
+                    correctedSoundFile.printStats(std::cout);
+                }
+            }
+        }
+
+        // Write XML
+        mediaFilenames.clear();
+        for(size_t j = 0; j < arrayToAnalyse.size(); ++j)
+        {
+            mediaFilenames.push_back(arrayToAnalyse.at(j)._filename);
+        }
+        writerXml.setSrcAudioFilenames(mediaFilenames);
+        std::stringstream ss;
+        ss << soundFile.getNbChannelsToAnalyse(i);
+        ss << " channels";
+        Loudness::common::ScopedTrace trace("xml");
+        writerXml.writeResults(ss.str(), analyser, (settings.correction)? gain : 1.0, groups.at(i).name);
+    }
+}
+
+/**
+ * @return the directory shared by all the files, with its final '/' (empty if there is none)
+ */
+std::string getCommonDirectory(const std::vector<std::string>& filenames)
+{
+    std::string directory = filenames.at(0).substr(0, filenames.at(0).find_last_of('/') + 1);
+    for(std::vector<std::string>::const_iterator it = filenames.begin(); it != filenames.end(); ++it)
+    {
+        while(it->compare(0, directory.size(), directory) != 0)
+        {
+            const size_t parent = directory.size() > 1 ? directory.find_last_of('/', directory.size() - 2) : std::string::npos;
+            directory = parent == std::string::npos ? "" : directory.substr(0, parent + 1);
+        }
+    }
+    return directory;
+}
+
+/**
+ * @brief Analyse the configuration files in a pool of threads, in a single process which initialises the codecs once.
+ * The report of each configuration file is written next to it. Its corrected file and progress file are suffixed by
+ * its path relative to the directory shared by all the configuration files.
+ * The configuration files whose outputs would have the same name are not analysed.
+ * @return the number of configuration files which could not be analysed
+ */
+size_t analyseBatch(const std::vector<std::string>& configFilenames, const AnalysisSettings& settings, const size_t nbThreads)
+{
+    std::mutex consoleMutex;
+    size_t nbErrors = 0;
+    if(configFilenames.empty())
+        return nbErrors;
+
+    // Name the outputs of each configuration file
+    const std::string commonDirectory = getCommonDirectory(configFilenames);
+    std::vector<AnalysisSettings> configSettings(configFilenames.size(), settings);
+    std::vector<std::string> configNames;
+    std::map<std::string, size_t> outputCounts;
+    for(size_t i = 0; i < configFilenames.size(); ++i)
+    {
+        const std::string& configFilename = configFilenames.at(i);
+        const size_t extension = findExtension(configFilename);
+        configSettings.at(i).verbose = false;
+        configSettings.at(i).outputXMLReportName = configFilename.substr(0, extension) + ".xml";
+        if(configSettings.at(i).outputXMLReportName == configFilename)
+            configSettings.at(i).outputXMLReportName += ".xml";
+
+        std::string configName = configFilename.substr(
+            commonDirectory.size(), extension == std::string::npos ? extension : extension - commonDirectory.size());
+        std::replace(configName.begin(), configName.end(), '/', '_');
+        configNames.push_back(configName);
+        if(!settings.correctionOutputFile.empty())
+            configSettings.at(i).correctionOutputFile = addSuffix(settings.correctionOutputFile, configName);
+        if(!settings.outputProgressionName.empty())
+            configSettings.at(i).outputProgressionName = addSuffix(settings.outputProgressionName, configName);
+
+        outputCounts[configSettings.at(i).outputXMLReportName]++;
+        outputCounts[configName]++;
+    }
+
+    Loudness::common::ThreadPool threadPool(nbThreads);
+    for(size_t i = 0; i < configFilenames.size(); ++i)
+    {
+        const std::string configFilename = configFilenames.at(i);
+        const AnalysisSettings& configSetting = configSettings.at(i);
+
+        // two configuration files cannot write the same outputs
+        if(outputCounts[configSetting.outputXMLReportName] > 1 || outputCounts[configNames.at(i)] > 1)
+        {
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cout << "Error during the loudness analysis of " << configFilename << ":" << std::endl;
+            std::cout << "Another configuration file has outputs of the same name." << std::endl;
+            nbErrors++;
+            continue;
+        }
+
+        threadPool.submit([&configSetting, &consoleMutex, &nbErrors, configFilename]() {
+            try
+            {
+                analyseConfigFile(configFilename, configSetting);
+                std::lock_guard<std::mutex> lock(consoleMutex);
+                std::cout << configFilename << ": " << configSetting.outputXMLReportName << std::endl;
+            }
+            catch(const std::exception& e)
+            {
+                std::lock_guard<std::mutex> lock(consoleMutex);
+                std::cout << "Error during the loudness analysis of " << configFilename << ":" << std::endl;
+                std::cout << e.what() << std::endl;
+                nbErrors++;
+            }
+        });
+    }
+    threadPool.wait();
+    return nbErrors;
 }
 
 void printHelp()
@@ -59,29 +351,47 @@ void printHelp()
     std::string help;
     help += "Usage\n";
     help += "\tmedia-analyser CONFIG.TXT [--output XMLReportName][--progressionInFile "
-            "progressionName][--forceDurationToAnalyse durationToAnalyse][--correction outputFile][--help]\n";
+            "progressionName][--forceDurationToAnalyse durationToAnalyse][--start=seconds][--end=seconds][--correction outputFile][--spill-cache=directory][--spill-budget=MB][--stats][--trace=file.json][--help]\n";
+    help += "\tmedia-analyser --batch [CONFIG.TXT...][--threads=N][options]\n";
     help += "CONFIG.TXT\n";
     help += "\tEach line will be one audio stream analysed by the loudness library.\n";
     help += "\tPattern of each line is:\n";
     help += "\t[inputFile]=STREAM_INDEX.CHANNEL_INDEX\n";
+    help += "\tA line [name] starts a group of audio streams: each group is analysed as a program, from a single decode of "
+            "the inputs.\n";
     help += "Command line options\n";
     help += "\t--help: display this help\n";
     help += "\t--progressionInFile: to print the progression in a file instead of in console\n";
     help += "\t--output: filename of the XML report\n";
     help += "\t--forceDurationToAnalyse: to force loudness analysis on a specific duration (in seconds). By default this is "
             "the duration of the input.\n";
-    help += "\t--correction: enable loudness correction, and write the corrected streams to the specified output file\n";
+    help += "\t--start / --end: analyse only this range of the inputs (in seconds), --end overrides "
+            "--forceDurationToAnalyse\n";
+    help += "\t--correction: enable loudness correction, and write the corrected streams to the specified output file "
+            "(suffixed by the name of each group if there are several)\n";
+    help += "\t--spill-cache: with --correction, keep the decoded samples of the analysis in a scratch file of the "
+            "directory, so that the correction does not decode the inputs again\n";
+    help += "\t--spill-budget: maximum size of the scratch file in MB (2048 by default), the correction decodes the "
+            "inputs again if the samples exceed it\n";
+    help += "\t--stats: print the time spent in each stage of the analysis, of the correction and of the I/O\n";
+    help += "\t--batch: analyse each configuration file given in the arguments (or read from the standard input, one per "
+            "line) in a single process, and write its XML report next to it (CONFIG.xml)\n";
+    help += "\t--threads=N: number of configuration files analysed at once in batch mode (the number of cores by default, 0 "
+            "to analyse them one after the other)\n";
+    help += "\t--trace=file.json: write the timeline of the processing in the Chrome trace event format (or set the "
+            "LOUDNESS_TRACE environment variable to the file)\n";
     std::cout << help << std::endl;
 }
 
 int main(int argc, char** argv)
 {
-    std::string outputXMLReportName("PLoud.xml");
-    std::string outputProgressionName;
-    float durationToAnalyse = 0;
+    AnalysisSettings settings;
+    float endTime = 0;
+    std::string traceFilename;
 
-    bool correction = false;
-    std::string correctionOutputFile;
+    bool batch = false;
+    size_t nbThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<std::string> configFilenames;
 
     // Check required arguments
     if(argc < 2)
@@ -108,7 +418,7 @@ int main(int argc, char** argv)
         {
             try
             {
-                outputXMLReportName = arguments.at(++argument);
+                settings.outputXMLReportName = arguments.at(++argument);
             }
             catch(...)
             {
@@ -120,7 +430,7 @@ int main(int argc, char** argv)
         {
             try
             {
-                outputProgressionName = arguments.at(++argument);
+                settings.outputProgressionName = arguments.at(++argument);
             }
             catch(...)
             {
@@ -132,7 +442,7 @@ int main(int argc, char** argv)
         {
             try
             {
-                durationToAnalyse = atof(arguments.at(++argument).c_str());
+                settings.durationToAnalyse = atof(arguments.at(++argument).c_str());
             }
             catch(...)
             {
@@ -142,10 +452,10 @@ int main(int argc, char** argv)
         }
         else if(arguments.at(argument) == "--correction")
         {
-            correction = true;
+            settings.correction = true;
             try
             {
-                correctionOutputFile = arguments.at(++argument);
+                settings.correctionOutputFile = arguments.at(++argument);
             }
             catch(...)
             {
@@ -153,52 +463,78 @@ int main(int argc, char** argv)
                 return 1;
             }
         }
+        else if(arguments.at(argument) == "--stats")
+        {
+            settings.showStats = true;
+        }
+        else if(arguments.at(argument).compare(0, 8, "--trace=") == 0)
+        {
+            traceFilename = arguments.at(argument).substr(8);
+        }
+        else if(arguments.at(argument).compare(0, 8, "--start=") == 0)
+        {
+            settings.startTime = atof(arguments.at(argument).substr(8).c_str());
+        }
+        else if(arguments.at(argument).compare(0, 6, "--end=") == 0)
+        {
+            endTime = atof(arguments.at(argument).substr(6).c_str());
+        }
+        else if(arguments.at(argument).compare(0, 14, "--spill-cache=") == 0)
+        {
+            settings.spillCacheDirectory = arguments.at(argument).substr(14);
+        }
+        else if(arguments.at(argument).compare(0, 15, "--spill-budget=") == 0)
+        {
+            settings.spillBudgetInMB = atol(arguments.at(argument).substr(15).c_str());
+        }
+        else if(arguments.at(argument) == "--batch")
+        {
+            batch = true;
+        }
+        else if(arguments.at(argument).compare(0, 10, "--threads=") == 0)
+        {
+            nbThreads = atol(arguments.at(argument).substr(10).c_str());
+        }
+        else if(arguments.at(argument).compare(0, 2, "--") != 0)
+        {
+            configFilenames.push_back(arguments.at(argument));
+        }
         // unknown option
         continue;
     }
 
-    avtranscoder::preloadCodecsAndFormats();
-    avtranscoder::Logger::setLogLevel(AV_LOG_QUIET);
-
-    try
+    if(endTime != 0 && endTime <= settings.startTime)
     {
-        // Get list of files / streamIndex to analyse
-        std::vector<avtranscoder::InputStreamDesc> arrayToAnalyse = parseConfigFile(arguments.at(0));
-        AvSoundFile soundFile(arrayToAnalyse);
-        soundFile.setProgressionFile(outputProgressionName);
-        soundFile.setDurationToAnalyse(durationToAnalyse);
-
-        // Analyse loudness according to EBU R-128
-        Loudness::analyser::LoudnessLevels level = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
-        Loudness::analyser::LoudnessAnalyser analyser(level);
-        soundFile.analyse(analyser);
-
-        // Print analyse
-        analyser.printPloudValues();
-        const float gain = analyser.getCorrectionGain();
+        std::cout << "Error: the end of the range must be after its start" << std::endl;
+        return 1;
+    }
+    if(endTime > 0)
+        settings.durationToAnalyse = endTime - settings.startTime;
 
-        if(correction && std::fabs(1.0 - gain) > 0.001)
+    // Without configuration file in the arguments, the batch reads them from the standard input, one per line
+    if(batch && configFilenames.empty())
+    {
+        std::string line;
+        while(std::getline(std::cin, line))
         {
-            std::cout << "Correction with gain " << gain << std::endl;
-            AvSoundFile correctedSoundFile(arrayToAnalyse);
-            correctedSoundFile.setProgressionFile(outputProgressionName);
-            correctedSoundFile.setDurationToAnalyse(durationToAnalyse);
-            correctedSoundFile.correct(analyser, correctionOutputFile, gain);
-
-            analyser.printPloudValues();
+            if(!line.empty())
+                configFilenames.push_back(line);
         }
+    }
 
-        // Write XML
-        std::vector<std::string> mediaFilenames;
-        for(size_t i = 0; i < arrayToAnalyse.size(); ++i)
-        {
-            mediaFilenames.push_back(arrayToAnalyse.at(i)._filename);
-        }
-        Loudness::tools::WriteXml writerXml(outputXMLReportName, mediaFilenames);
-        std::stringstream ss;
-        ss << soundFile.getNbChannelsToAnalyse();
-        ss << " channels";
-        writerXml.writeResults(ss.str(), analyser, (correction)? gain : 1.0);
+    avtranscoder::preloadCodecsAndFormats();
+    avtranscoder::Logger::setLogLevel(AV_LOG_QUIET);
+
+    Loudness::common::TraceSession traceSession(traceFilename);
+    if(batch)
+    {
+        const size_t nbErrors = analyseBatch(configFilenames, settings, nbThreads);
+        return nbErrors ? 1 : 0;
+    }
+
+    try
+    {
+        analyseConfigFile(arguments.at(0), settings);
     }
     catch(const std::exception& e)
     {
@@ -0,0 +1,600 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+#include <loudnessAnalyser/LoudnessAnalyser.hpp>
+#include <loudnessCorrector/LookAheadLimiter.hpp>
+#include <loudnessCorrector/CorrectBuffer.hpp>
+#include <loudnessCorrector/PeakLimiter.hpp>
+#include <loudnessTools/SignalGenerator.hpp>
+
+#ifndef __WINDOWS__
+#include <sys/resource.h>
+#endif
+
+enum ESignal
+{
+    eSignalProgramme = 0, ///< cycles of pink noise, silence gap, tone and quiet pink noise
+    eSignalTone,          ///< 997Hz at -20dBFS on all channels
+    eSignalPinkNoise,     ///< pink noise on all channels
+    eSignalEbu3341,       ///< 1kHz at -23dBFS on the two first channels (-23 LUFS), others silent
+    eSignalEbu3342        ///< 1kHz on the two first channels, 20s at -20dBFS then 20s at -30dBFS (10 LU of LRA)
+};
+
+/**
+ * Deterministic multichannel programme, generated block by block.
+ */
+class Programme
+{
+public:
+    Programme(const ESignal signal, const size_t nbChannels, const size_t sampleRate)
+        : _signal(signal)
+        , _sampleRate(sampleRate)
+        , _position(0)
+    {
+        for(size_t c = 0; c < nbChannels; c++)
+            _generators.push_back(Loudness::tools::SignalGenerator(sampleRate, c + 1));
+    }
+
+    void generate(std::vector<std::vector<float> >& channels, const size_t nbFrames)
+    {
+        // segments are aligned on the seconds
+        size_t frame = 0;
+        while(frame < nbFrames)
+        {
+            const size_t second = _position / _sampleRate;
+            const size_t segmentFrames = std::min(nbFrames - frame, (second + 1) * _sampleRate - _position);
+            for(size_t c = 0; c < _generators.size(); c++)
+                generateSegment(c, second, &channels[c][frame], segmentFrames);
+            frame += segmentFrames;
+            _position += segmentFrames;
+        }
+    }
+
+private:
+    void generateSegment(const size_t channel, const size_t second, float* samples, const size_t nbFrames)
+    {
+        Loudness::tools::SignalGenerator& generator = _generators[channel];
+        const bool frontChannel = channel < 2;
+        switch(_signal)
+        {
+            case eSignalProgramme:
+            {
+                // one minute: 20s of pink noise, 5s of silence, 15s of tone, 20s of quiet pink noise
+                const size_t time = second % 60;
+                const float surroundGain = channel < 3 ? 1.0 : 0.5;
+                if(time < 20)
+                    generator.generatePinkNoise(samples, nbFrames, 0.25 * surroundGain);
+                else if(time < 25)
+                    generator.generateSilence(samples, nbFrames);
+                else if(time < 40)
+                    generator.generateSine(samples, nbFrames, 997.0, 0.1 * surroundGain);
+                else
+                    generator.generatePinkNoise(samples, nbFrames, 0.05 * surroundGain);
+                break;
+            }
+            case eSignalTone:
+                generator.generateSine(samples, nbFrames, 997.0, 0.1);
+                break;
+            case eSignalPinkNoise:
+                generator.generatePinkNoise(samples, nbFrames, 0.25);
+                break;
+            case eSignalEbu3341:
+                if(frontChannel)
+                    generator.generateSine(samples, nbFrames, 1000.0, std::pow(10.0, -23.0 / 20));
+                else
+                    generator.generateSilence(samples, nbFrames);
+                break;
+            case eSignalEbu3342:
+                if(frontChannel)
+                    generator.generateSine(samples, nbFrames, 1000.0,
+                                           std::pow(10.0, ((second / 20) % 2 ? -30.0 : -20.0) / 20));
+                else
+                    generator.generateSilence(samples, nbFrames);
+                break;
+        }
+    }
+
+    const ESignal _signal;
+    const size_t _sampleRate;
+    size_t _position; ///< in frames
+    std::vector<Loudness::tools::SignalGenerator> _generators;
+};
+
+/**
+ * Accumulated time of a stage of a pipeline.
+ */
+class Stage
+{
+public:
+    Stage(const std::string& name)
+        : _name(name)
+        , _seconds(0)
+    {
+    }
+
+    void start() { _start = std::chrono::steady_clock::now(); }
+    void stop() { _seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+
+    const std::string& getName() const { return _name; }
+    double getSeconds() const { return _seconds; }
+
+private:
+    std::string _name;
+    double _seconds;
+    std::chrono::steady_clock::time_point _start;
+};
+
+struct Settings
+{
+    size_t sampleRate;
+    size_t nbChannels;
+    std::string layout;
+    double duration; ///< in seconds
+    size_t blockSize;
+    ESignal signal;
+    bool lazyTruePeak;
+    Loudness::analyser::ETruePeakFilter truePeakFilter;
+};
+
+void initAnalyser(Loudness::analyser::LoudnessAnalyser& analyser, const Settings& settings)
+{
+    analyser.enableLazyTruePeak(settings.lazyTruePeak);
+    analyser.setTruePeakFilter(settings.truePeakFilter);
+    analyser.initAndStart(settings.nbChannels, settings.sampleRate);
+}
+
+void printResults(Loudness::analyser::LoudnessAnalyser& analyser)
+{
+    std::cout << "\t\tI = " << analyser.getIntegratedLoudness() << " LUFS, LRA = " << analyser.getIntegratedRange()
+              << " LU, TP = " << analyser.getTruePeakInDbTP() << " dBTP" << std::endl;
+}
+
+void printStages(const std::string& pipeline, const std::vector<Stage>& stages, const Settings& settings)
+{
+    // the generation replaces the decoding of a file: it is not a part of the pipeline
+    double total = 0;
+    double generation = 0;
+    for(size_t i = 0; i < stages.size(); i++)
+    {
+        total += stages.at(i).getSeconds();
+        if(stages.at(i).getName() == "generate")
+            generation += stages.at(i).getSeconds();
+    }
+
+    std::cout << pipeline << ": " << total << " s, realtime factor = " << settings.duration / (total - generation)
+              << " (without generation)" << std::endl;
+    for(size_t i = 0; i < stages.size(); i++)
+    {
+        std::cout << "\t" << std::left << std::setw(24) << stages.at(i).getName() << std::right << std::setw(12)
+                  << stages.at(i).getSeconds() << " s" << std::setw(8) << std::setprecision(3)
+                  << 100.0 * stages.at(i).getSeconds() / total << " %" << std::setprecision(6) << std::endl;
+    }
+}
+
+/**
+ * loudness-analyser: analysis of planar samples.
+ * \return correction gain of the programme
+ */
+float runAnalyserPipeline(const Settings& settings)
+{
+    std::vector<Stage> stages;
+    stages.push_back(Stage("generate"));
+    stages.push_back(Stage("analyse"));
+
+    Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+    Loudness::analyser::LoudnessAnalyser analyser(levels);
+    initAnalyser(analyser, settings);
+
+    Programme programme(settings.signal, settings.nbChannels, settings.sampleRate);
+    std::vector<std::vector<float> > channels(settings.nbChannels, std::vector<float>(settings.blockSize));
+    std::vector<float*> data(settings.nbChannels);
+
+    size_t remainingFrames = settings.duration * settings.sampleRate;
+    while(remainingFrames)
+    {
+        const size_t nbFrames = std::min(remainingFrames, settings.blockSize);
+
+        stages.at(0).start();
+        programme.generate(channels, nbFrames);
+        stages.at(0).stop();
+
+        stages.at(1).start();
+        for(size_t c = 0; c < settings.nbChannels; c++)
+            data[c] = &channels[c][0];
+        analyser.processSamples(&data[0], nbFrames);
+        stages.at(1).stop();
+
+        remainingFrames -= nbFrames;
+    }
+
+    printStages("analyser", stages, settings);
+    printResults(analyser);
+    return analyser.getCorrectionGain(true);
+}
+
+/**
+ * loudness-corrector (with --enable-limiter), as CorrectFileWithCompressor: gain and look-ahead limiter of each channel
+ * on the interlaced samples read from the file, analysis of the result, then the samples delayed by the limiters.
+ */
+void runCorrectorPipeline(const Settings& settings, const float gain)
+{
+    std::vector<Stage> stages;
+    stages.push_back(Stage("generate"));
+    stages.push_back(Stage("interlace"));
+    stages.push_back(Stage("gain + look-ahead limiter"));
+    stages.push_back(Stage("deinterlace"));
+    stages.push_back(Stage("analyse corrected"));
+
+    Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+    Loudness::analyser::LoudnessAnalyser analyser(levels);
+    initAnalyser(analyser, settings);
+
+    const size_t nbChannels = settings.nbChannels;
+    const float threshold = std::pow(10, levels.truePeakTargetLevel / 20);
+    std::vector<Loudness::corrector::LookAheadLimiter*> limiters;
+    for(size_t c = 0; c < nbChannels; c++)
+        limiters.push_back(new Loudness::corrector::LookAheadLimiter(60.0, settings.sampleRate, threshold));
+
+    Programme programme(settings.signal, nbChannels, settings.sampleRate);
+    std::vector<std::vector<float> > channels(nbChannels, std::vector<float>(settings.blockSize));
+    std::vector<float> interlaced(nbChannels * settings.blockSize);
+    std::vector<float*> data(nbChannels);
+    for(size_t c = 0; c < nbChannels; c++)
+        data[c] = &channels[c][0];
+
+    size_t remainingFrames = settings.duration * settings.sampleRate;
+    while(true)
+    {
+        size_t nbFrames = std::min(remainingFrames, settings.blockSize);
+        if(nbFrames)
+        {
+            stages.at(0).start();
+            programme.generate(channels, nbFrames);
+            stages.at(0).stop();
+
+            // samples read from the file
+            stages.at(1).start();
+            for(size_t i = 0; i < nbFrames; i++)
+            {
+                for(size_t c = 0; c < nbChannels; c++)
+                    interlaced[i * nbChannels + c] = channels[c][i];
+            }
+            stages.at(1).stop();
+
+            // the limiters delay the samples: the corrected block is shorter at the beginning, but the whole read
+            // block is analysed
+            stages.at(2).start();
+            Loudness::corrector::correctBuffer(limiters, &interlaced[0], nbFrames, nbChannels, gain);
+            stages.at(2).stop();
+            remainingFrames -= nbFrames;
+        }
+        else
+        {
+            // end of the programme: samples still delayed by the limiters
+            stages.at(2).start();
+            nbFrames = Loudness::corrector::getLastData(limiters, &interlaced[0], settings.blockSize, nbChannels, gain);
+            stages.at(2).stop();
+            if(nbFrames == 0)
+                break;
+        }
+
+        stages.at(3).start();
+        for(size_t i = 0; i < nbFrames; i++)
+        {
+            for(size_t c = 0; c < nbChannels; c++)
+                channels[c][i] = interlaced[i * nbChannels + c];
+        }
+        stages.at(3).stop();
+
+        stages.at(4).start();
+        analyser.processSamples(&data[0], nbFrames);
+        stages.at(4).stop();
+    }
+
+    for(size_t c = 0; c < nbChannels; c++)
+        delete limiters.at(c);
+
+    printStages("corrector", stages, settings);
+    printResults(analyser);
+}
+
+/**
+ * adm-loudness-analyser (with --correction and --limiter), after the rendering: interlaced samples, analysis,
+ * gain and peak limiter, analysis of the result.
+ */
+void runAdmPipeline(const Settings& settings, const float gain)
+{
+    std::vector<Stage> stages;
+    stages.push_back(Stage("generate"));
+    stages.push_back(Stage("interlace"));
+    stages.push_back(Stage("analyse"));
+    stages.push_back(Stage("gain + peak limiter"));
+    stages.push_back(Stage("analyse corrected"));
+
+    Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+    Loudness::analyser::LoudnessAnalyser analyser(levels);
+    Loudness::analyser::LoudnessAnalyser analyserAfterCorrection(levels);
+    initAnalyser(analyser, settings);
+    initAnalyser(analyserAfterCorrection, settings);
+
+    const size_t nbChannels = settings.nbChannels;
+    const float threshold = std::pow(10, levels.truePeakTargetLevel / 20);
+    Loudness::corrector::PeakLimiter peakLimiter(1.0, 20.0, threshold, nbChannels, settings.sampleRate);
+
+    Programme programme(settings.signal, nbChannels, settings.sampleRate);
+    std::vector<std::vector<float> > channels(nbChannels, std::vector<float>(settings.blockSize));
+    std::vector<float> rendered(nbChannels * settings.blockSize);
+    std::vector<float> corrected(nbChannels * settings.blockSize);
+
+    size_t remainingFrames = settings.duration * settings.sampleRate;
+    while(remainingFrames)
+    {
+        const size_t nbFrames = std::min(remainingFrames, settings.blockSize);
+
+        stages.at(0).start();
+        programme.generate(channels, nbFrames);
+        stages.at(0).stop();
+
+        // output of the renderer
+        stages.at(1).start();
+        for(size_t i = 0; i < nbFrames; i++)
+        {
+            for(size_t c = 0; c < nbChannels; c++)
+                rendered[i * nbChannels + c] = channels[c][i];
+        }
+        stages.at(1).stop();
+
+        stages.at(2).start();
+        analyser.processInterleavedSamples(&rendered[0], nbFrames);
+        stages.at(2).stop();
+
+        stages.at(3).start();
+        for(size_t i = 0; i < nbFrames * nbChannels; i++)
+            rendered[i] *= gain;
+        peakLimiter.apply(&rendered[0], &corrected[0], nbFrames);
+        stages.at(3).stop();
+
+        stages.at(4).start();
+        analyserAfterCorrection.processInterleavedSamples(&corrected[0], nbFrames);
+        stages.at(4).stop();
+
+        remainingFrames -= nbFrames;
+    }
+
+    printStages("adm (after rendering)", stages, settings);
+    printResults(analyserAfterCorrection);
+}
+
+/**
+ * \return peak resident set size in MiB, or a negative value if unknown
+ */
+double getPeakResidentSetSize()
+{
+#ifndef __WINDOWS__
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef __MACOS__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // in bytes
+#else
+    return usage.ru_maxrss / 1024.0; // in kilobytes
+#endif
+#else
+    return -1;
+#endif
+}
+
+/**
+ * \return duration in seconds, with an optional unit: 90, 90s, 30m, 24h
+ */
+bool parseDuration(const std::string& value, double& duration)
+{
+    std::stringstream ss(value);
+    ss >> duration;
+    if(ss.fail() || duration <= 0)
+        return false;
+
+    std::string unit;
+    ss >> unit;
+    if(unit == "h")
+        duration *= 3600;
+    else if(unit == "m")
+        duration *= 60;
+    else if(!unit.empty() && unit != "s")
+        return false;
+    return true;
+}
+
+/**
+ * \return number of analysed channels: the LFE is not analysed, as in the applications
+ */
+bool parseLayout(const std::string& layout, size_t& nbChannels)
+{
+    if(layout == "1.0")
+        nbChannels = 1;
+    else if(layout == "2.0")
+        nbChannels = 2;
+    else if(layout == "5.0" || layout == "5.1")
+        nbChannels = 5;
+    else if(layout == "7.1")
+        nbChannels = 7;
+    else if(layout == "0+5+0")
+        nbChannels = 6; // rendered by the ADM renderer, with its LFE
+    else if(layout == "4+5+0")
+        nbChannels = 10;
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    settings.sampleRate = 48000;
+    settings.nbChannels = 2;
+    settings.layout = "2.0";
+    settings.duration = 600;
+    settings.blockSize = 4096;
+    settings.signal = eSignalProgramme;
+    settings.lazyTruePeak = false;
+    settings.truePeakFilter = Loudness::analyser::eTruePeakFilterLegacy;
+
+    bool runAnalyser = true;
+    bool runCorrector = true;
+    bool runAdm = true;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strncmp(argv[i], "--duration=", 11) == 0)
+        {
+            if(!parseDuration(argv[i] + 11, settings.duration))
+            {
+                std::cout << "Error: duration parameter take a number of seconds, or a duration in m or h. example: "
+                             "--duration=24h"
+                          << std::endl;
+                return -101;
+            }
+        }
+        else if(strncmp(argv[i], "--sample-rate=", 14) == 0)
+        {
+            settings.sampleRate = atoi(argv[i] + 14);
+            if(settings.sampleRate == 0)
+            {
+                std::cout << "Error: sample-rate parameter take only an integer into value. example: --sample-rate=48000"
+                          << std::endl;
+                return -101;
+            }
+        }
+        else if(strncmp(argv[i], "--layout=", 9) == 0)
+        {
+            settings.layout = argv[i] + 9;
+            if(!parseLayout(settings.layout, settings.nbChannels))
+            {
+                std::cout << "Error: unknown layout specified in command line" << std::endl;
+                return -100;
+            }
+        }
+        else if(strncmp(argv[i], "--block-size=", 13) == 0)
+        {
+            settings.blockSize = atoi(argv[i] + 13);
+            if(settings.blockSize == 0)
+            {
+                std::cout << "Error: block-size parameter take only an integer into value. example: --block-size=4096"
+                          << std::endl;
+                return -101;
+            }
+        }
+        else if(strncmp(argv[i], "--signal=", 9) == 0)
+        {
+            const char* signalName = argv[i] + 9;
+            if(strcmp(signalName, "programme") == 0)
+                settings.signal = eSignalProgramme;
+            else if(strcmp(signalName, "tone") == 0)
+                settings.signal = eSignalTone;
+            else if(strcmp(signalName, "pink") == 0)
+                settings.signal = eSignalPinkNoise;
+            else if(strcmp(signalName, "ebu3341") == 0)
+                settings.signal = eSignalEbu3341;
+            else if(strcmp(signalName, "ebu3342") == 0)
+                settings.signal = eSignalEbu3342;
+            else
+            {
+                std::cout << "Error: unknown signal specified in command line" << std::endl;
+                return -100;
+            }
+        }
+        else if(strncmp(argv[i], "--pipelines=", 12) == 0)
+        {
+            const std::string pipelines = argv[i] + 12;
+            runAnalyser = pipelines.find("analyser") != std::string::npos;
+            runCorrector = pipelines.find("corrector") != std::string::npos;
+            runAdm = pipelines.find("adm") != std::string::npos;
+        }
+        else if(strncmp(argv[i], "--true-peak=", 12) == 0)
+        {
+            const char* filterName = argv[i] + 12;
+            if(strcmp(filterName, "legacy") == 0)
+                settings.truePeakFilter = Loudness::analyser::eTruePeakFilterLegacy;
+            else if(strcmp(filterName, "strict2x") == 0)
+                settings.truePeakFilter = Loudness::analyser::eTruePeakFilterStrict2x;
+            else if(strcmp(filterName, "strict4x") == 0)
+                settings.truePeakFilter = Loudness::analyser::eTruePeakFilterStrict4x;
+            else if(strcmp(filterName, "strict8x") == 0)
+                settings.truePeakFilter = Loudness::analyser::eTruePeakFilterStrict8x;
+            else if(strcmp(filterName, "fast2x") == 0)
+                settings.truePeakFilter = Loudness::analyser::eTruePeakFilterFast2x;
+            else if(strcmp(filterName, "fast4x") == 0)
+                settings.truePeakFilter = Loudness::analyser::eTruePeakFilterFast4x;
+            else if(strcmp(filterName, "fast8x") == 0)
+                settings.truePeakFilter = Loudness::analyser::eTruePeakFilterFast8x;
+            else
+            {
+                std::cout << "Error: unknown true peak filter specified in command line" << std::endl;
+                return -100;
+            }
+        }
+        else if(strcmp(argv[i], "--lazy-true-peak") == 0)
+        {
+            settings.lazyTruePeak = true;
+        }
+        else
+        {
+            std::cout << "Loudness Throughput " << std::endl << std::endl;
+            std::cout << "Measure the speed of the loudness pipelines on generated programmes (no file is read or written)."
+                      << std::endl
+                      << std::endl;
+            std::cout << "Common usage :" << std::endl;
+            std::cout << "\tloudness-throughput [options]" << std::endl << std::endl;
+            std::cout << "Options :" << std::endl;
+            std::cout << "\t--duration=<duration>: length of the programme, in s, m or h (default is 600s). example: "
+                         "--duration=24h"
+                      << std::endl;
+            std::cout << "\t--sample-rate=<rate>: sample rate of the programme (default is 48000)" << std::endl;
+            std::cout << "\t--layout=1.0/2.0/5.0/5.1/7.1/0+5+0/4+5+0: channels of the programme (default is 2.0)"
+                      << std::endl;
+            std::cout << "\t\t\tthe LFE of 5.1 and 7.1 is skipped, as in loudness-analyser" << std::endl;
+            std::cout << "\t\t\t0+5+0 and 4+5+0 are the outputs of the ADM renderer" << std::endl;
+            std::cout << "\t--signal=programme/tone/pink/ebu3341/ebu3342: content of the programme" << std::endl;
+            std::cout << "\t\t\tprogramme: each minute, pink noise, silence, tone and quiet pink noise (default)"
+                      << std::endl;
+            std::cout << "\t\t\ttone: 997Hz at -20dBFS" << std::endl;
+            std::cout << "\t\t\tpink: pink noise" << std::endl;
+            std::cout << "\t\t\tebu3341: 1kHz at -23dBFS on the front channels (EBU Tech 3341, -23 LUFS in stereo)"
+                      << std::endl;
+            std::cout << "\t\t\tebu3342: 1kHz, 20s at -20dBFS then 20s at -30dBFS (EBU Tech 3342, 10 LU of LRA)"
+                      << std::endl;
+            std::cout << "\t--block-size=<frames>: frames given to the analyser at once (default is 4096)" << std::endl;
+            std::cout << "\t--pipelines=analyser,corrector,adm: pipelines to run (default is all)" << std::endl;
+            std::cout << "\t--lazy-true-peak: oversample only the blocks which can raise the TruePeak of the program"
+                      << std::endl;
+            std::cout << "\t--true-peak=legacy/strict2x/strict4x/strict8x/fast2x/fast4x/fast8x: oversampling filter"
+                      << std::endl;
+            return -1;
+        }
+    }
+
+    std::cout << "programme: " << settings.duration << " s of " << settings.layout << " at " << settings.sampleRate
+              << " Hz (" << settings.nbChannels << " analysed channels), blocks of " << settings.blockSize << " frames"
+              << std::endl;
+
+    // the correction gain is measured by the analyser pipeline
+    float gain = 1.0;
+    if(runAnalyser || runCorrector || runAdm)
+        gain = runAnalyserPipeline(settings);
+    if(runCorrector)
+        runCorrectorPipeline(settings, gain);
+    if(runAdm)
+        runAdmPipeline(settings, gain);
+
+    const double peakResidentSetSize = getPeakResidentSetSize();
+    if(peakResidentSetSize >= 0)
+        std::cout << "peak RSS: " << peakResidentSetSize << " MiB" << std::endl;
+    return 0;
+}
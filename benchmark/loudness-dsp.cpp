@@ -0,0 +1,240 @@
+#include <loudnessAnalyser/LoudnessAnalyser.hpp>
+#include <loudnessAnalyser/Filter.hpp>
+#include <loudnessAnalyser/TruePeakMeter.hpp>
+#include <loudnessAnalyser/Histogram.hpp>
+#include <loudnessCorrector/PeakLimiter.hpp>
+#include <loudnessCorrector/LookAheadLimiter.hpp>
+#include <loudnessTools/SignalGenerator.hpp>
+
+#include "benchmark/benchmark.h"
+
+#include <vector>
+
+/**
+ * Micro-benchmarks of the DSP kernels, on deterministic synthetic signals.
+ * The items processed are samples (of one channel), so items_per_second compares to the sample rate.
+ */
+
+static const float sampleRate = 48000;
+static const size_t signalLength = 48000; // one second per channel
+
+/**
+ * @brief Music-like signal of one second: pink noise at about -12 dBFS.
+ */
+static std::vector<float> getPinkNoise(const unsigned int seed = 1)
+{
+    std::vector<float> signal(signalLength);
+    Loudness::tools::SignalGenerator generator(sampleRate, seed);
+    generator.generatePinkNoise(&signal[0], signal.size(), 0.25);
+    return signal;
+}
+
+static void BM_FilterProcessSample(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    Loudness::analyser::Filter filter;
+    filter.initializeFilterCoefficients(sampleRate);
+    filter.reset();
+
+    for(auto _ : state)
+    {
+        float sumOfPower = 0;
+        for(size_t i = 0; i < signal.size(); i++)
+        {
+            const float filtered = filter.processSample(signal[i]);
+            sumOfPower += filtered * filtered;
+        }
+        benchmark::DoNotOptimize(sumOfPower);
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(BM_FilterProcessSample);
+
+static void BM_FilterProcessBlock(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    Loudness::analyser::Filter filter;
+    filter.initializeFilterCoefficients(sampleRate);
+    filter.reset();
+
+    for(auto _ : state)
+        benchmark::DoNotOptimize(filter.processBlock(&signal[0], signal.size()));
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(BM_FilterProcessBlock);
+
+/**
+ * @brief Legacy filter, args: upsampling frequency, SIMD optimization.
+ */
+static void BM_TruePeakMeterLegacy(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    Loudness::analyser::TruePeakMeter meter;
+    meter.setUpsamplingFrequencyInHz(state.range(0));
+    meter.enableOptimization(state.range(1));
+    meter.initialize(sampleRate);
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < signal.size(); i++)
+            benchmark::DoNotOptimize(meter.processSample(signal[i]));
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(BM_TruePeakMeterLegacy)
+    ->ArgNames({"upsampling", "simd"})
+    ->ArgsProduct({{96000, 192000, 384000}, {0, 1}});
+
+/**
+ * @brief Filter designs, args: ETruePeakFilter, SIMD optimization.
+ */
+static void BM_TruePeakMeterFilter(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    Loudness::analyser::TruePeakMeter meter;
+    meter.setFilter(static_cast<Loudness::analyser::ETruePeakFilter>(state.range(0)));
+    meter.enableOptimization(state.range(1));
+    meter.initialize(sampleRate);
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < signal.size(); i++)
+            benchmark::DoNotOptimize(meter.processSample(signal[i]));
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(BM_TruePeakMeterFilter)
+    ->ArgNames({"filter", "simd"})
+    ->ArgsProduct({{Loudness::analyser::eTruePeakFilterStrict2x, Loudness::analyser::eTruePeakFilterStrict4x,
+                    Loudness::analyser::eTruePeakFilterStrict8x, Loudness::analyser::eTruePeakFilterFast2x,
+                    Loudness::analyser::eTruePeakFilterFast4x, Loudness::analyser::eTruePeakFilterFast8x},
+                   {0, 1}});
+
+/**
+ * @brief Lazy evaluation of the legacy filter, on blocks of 10ms under the gate (the usual case of a program).
+ */
+static void BM_TruePeakMeterLazyBlock(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    const size_t blockSize = sampleRate / 100;
+    Loudness::analyser::TruePeakMeter meter;
+    meter.initialize(sampleRate);
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i + blockSize <= signal.size(); i += blockSize)
+        {
+            const float blockPeak = meter.computePeak(&signal[i], blockSize);
+            benchmark::DoNotOptimize(meter.processBlock(&signal[i], blockSize, blockPeak, 10.0));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(BM_TruePeakMeterLazyBlock);
+
+static void BM_HistogramAddValue(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    Loudness::analyser::Histogram histogram(-70.0, 5.0, 0.01);
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < signal.size(); i++)
+            histogram.addValue(-75.0 + 80.0 * std::abs(signal[i]));
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(BM_HistogramAddValue);
+
+/**
+ * @brief Queries of the integrated loudness and of the loudness range, on the histogram of a program.
+ */
+static void BM_HistogramQueries(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    Loudness::analyser::Histogram histogram(-70.0, 5.0, 0.01);
+    for(size_t i = 0; i < signal.size(); i++)
+        histogram.addValue(-75.0 + 80.0 * std::abs(signal[i]));
+
+    for(auto _ : state)
+    {
+        const float threshold = histogram.integratedValue(-70.0, 5.0) - 10.0;
+        benchmark::DoNotOptimize(histogram.integratedValue(threshold, 5.0));
+        benchmark::DoNotOptimize(histogram.foundMinPercentageFrom(10.0, threshold, 5.0));
+        benchmark::DoNotOptimize(histogram.foundMaxPercentageFrom(95.0, threshold, 5.0));
+    }
+}
+BENCHMARK(BM_HistogramQueries);
+
+/**
+ * @brief Whole analysis, args: number of channels, samples per call of processSamples.
+ */
+static void BM_LoudnessAnalyserProcess(benchmark::State& state)
+{
+    const size_t nbChannels = state.range(0);
+    const size_t blockSize = state.range(1);
+
+    std::vector<std::vector<float> > signals;
+    for(size_t c = 0; c < nbChannels; c++)
+        signals.push_back(getPinkNoise(c + 1));
+
+    Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+    Loudness::analyser::LoudnessAnalyser analyser(levels);
+    analyser.initAndStart(nbChannels, sampleRate);
+
+    std::vector<float*> data(nbChannels);
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i + blockSize <= signalLength; i += blockSize)
+        {
+            for(size_t c = 0; c < nbChannels; c++)
+                data[c] = &signals[c][i];
+            analyser.processSamples(&data[0], blockSize);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (signalLength / blockSize) * blockSize * nbChannels);
+}
+BENCHMARK(BM_LoudnessAnalyserProcess)
+    ->ArgNames({"channels", "block"})
+    ->ArgsProduct({{1, 2, 5, 6, 8}, {64, 1024, 8192}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Interlaced brick wall limiter, args: number of channels.
+ */
+static void BM_PeakLimiter(benchmark::State& state)
+{
+    const size_t nbChannels = state.range(0);
+    const std::vector<float> signal = getPinkNoise();
+    const size_t nbFrames = signal.size() / nbChannels;
+    std::vector<float> output(signal.size());
+
+    Loudness::corrector::PeakLimiter limiter(10.0, 200.0, 0.5, nbChannels, sampleRate);
+    for(auto _ : state)
+    {
+        limiter.apply(&signal[0], &output[0], nbFrames);
+        benchmark::DoNotOptimize(output[0]);
+    }
+    state.SetItemsProcessed(state.iterations() * nbFrames * nbChannels);
+}
+BENCHMARK(BM_PeakLimiter)->ArgName("channels")->Arg(2)->Arg(6);
+
+static void BM_LookAheadLimiter(benchmark::State& state)
+{
+    const std::vector<float> signal = getPinkNoise();
+    Loudness::corrector::LookAheadLimiter limiter(60.0, sampleRate, 0.5);
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < signal.size(); i++)
+        {
+            float sample = signal[i] * 2;
+            benchmark::DoNotOptimize(limiter.process(sample));
+            benchmark::DoNotOptimize(sample);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(BM_LookAheadLimiter);
+
+BENCHMARK_MAIN();
@@ -1,13 +1,17 @@
 
 #include "AdmLoudnessAnalyser.hpp"
+#include "RiffChunks.hpp"
 
 #include <adm_engine/utils.hpp>
 #include <adm_engine/adm_helper.hpp>
 #include <adm_engine/parser.hpp>
 
-#include <loudnessCorrector/PeakLimiter.hpp>
+#include <loudnessCommon/ThreadPool.hpp>
 
-#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <sstream>
 #include <sys/stat.h>
 
 namespace Loudness
@@ -16,10 +20,27 @@ namespace Loudness
 namespace admanalyser
 {
 
+// room left in the axml chunk of a corrected file, for the loudness values after correction
+static const size_t AXML_CHUNK_MARGIN = 1024;
 
-struct stat s;
+namespace
+{
+
+// messages on the standard outputs, a line per message
+void defaultLogger(const std::string& level, const std::string& message) {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if(level == "error" || level == "warn") {
+        std::cerr << message << std::endl;
+    } else {
+        std::cout << message << std::endl;
+    }
+}
+
+}
 
 EPathType AdmLoudnessAnalyser::getPathType(const std::string& path) {
+    struct stat s;
     if(stat(path.c_str(), &s) == 0)
     {
         if( s.st_mode & S_IFDIR ) {
@@ -43,13 +64,27 @@ AdmLoudnessAnalyser::AdmLoudnessAnalyser(const std::string& inputFilePath,
                                          const std::string& audioProgrammeIdToRender)
     : _inputFilePath(inputFilePath)
     , _inputFile(bw64::readFile(_inputFilePath))
+    , _outputLayout(outputLayout)
+    , _elementGainsMapping(elementGainsMapping)
     , _renderer(_inputFile, outputLayout, ".", elementGainsMapping, audioProgrammeIdToRender)
     , _outputPath(outputPath)
     , _audioProgrammeIdToRender(audioProgrammeIdToRender)
-    , _outputPathsList() {
+    , _outputPathsList()
+    , _levels(Loudness::analyser::LoudnessLevels::Loudness_EBU_R128())
+    , _nbThreads(1)
+    , _firstFrame(0)
+    , _lastFrame(_inputFile->numberOfFrames())
+    , _logger(defaultLogger)
+    , _progressToken(NULL) {
 
 }
 
+void AdmLoudnessAnalyser::setRange(const size_t firstFrame, const size_t lastFrame) {
+    const size_t nbFrames = _inputFile->numberOfFrames();
+    _lastFrame = (lastFrame == 0 || lastFrame > nbFrames) ? nbFrames : lastFrame;
+    _firstFrame = std::min(firstFrame, _lastFrame);
+}
+
 std::shared_ptr<adm::Document> AdmLoudnessAnalyser::process(const bool displayValues, const bool enableCorrection, const bool enableLimiter) {
     std::shared_ptr<adm::Document> admDocument = _renderer.getDocument();
     const std::shared_ptr<bw64::ChnaChunk> chnaChunk = _renderer.getAdmChnaChunk();
@@ -66,86 +101,105 @@ std::shared_ptr<adm::Document> AdmLoudnessAnalyser::process(const bool displayVa
         throw std::runtime_error("Invalid argument: analyse output path cannot be a directory.");
     }
 
+    if(audioProgrammes.empty()) {
+        throw std::runtime_error("No ADM audio programme found.");
+    }
 
-    if(audioProgrammes.size()) {
-        for(auto audioProgramme : audioProgrammes) {
+    std::vector<std::unique_ptr<ProgrammeProcess>> programmes;
+    for(auto audioProgramme : audioProgrammes) {
+        const std::string audioProgrammeId = formatId(audioProgramme->get<adm::AudioProgrammeId>());
+        if(!_audioProgrammeIdToRender.empty() &&
+            _audioProgrammeIdToRender != audioProgrammeId) {
+            // skip audioProgramme
+            continue;
+        }
+        programmes.push_back(createProgrammeProcess(audioProgramme, programmes.empty()));
+    }
 
-            const std::string audioProgrammeId = formatId(audioProgramme->get<adm::AudioProgrammeId>());
+    // Analyse all the audio programmes in a single read of the input file
+    analyseProgrammes(programmes, displayValues, enableCorrection ? 50 : 100);
 
-            if(!_audioProgrammeIdToRender.empty() &&
-                _audioProgrammeIdToRender != audioProgrammeId) {
-                // skip audioProgramme
-                continue;
+    if(enableCorrection) {
+        for(auto& programme : programmes) {
+            std::shared_ptr<adm::AudioProgramme> audioProgramme = programme->audioProgramme;
+            const std::string programmeTitle = admengine::replaceSpecialCharacters(audioProgramme->get<adm::AudioProgrammeName>().get());
+
+            std::stringstream outputFilePath;
+            outputFilePath << _outputPath << "/";
+            outputFilePath << programmeTitle << "_loudness_corrected.wav";
+            log("info", "Write corrected output file with updated ADM document: " + outputFilePath.str());
+
+            // The loudness of the corrected programme is known at the end of the correction:
+            // reserve the axml chunk with the loudness before correction (and a margin), it is overwritten at the end
+            audioProgramme->set(getLoudnessMetadata(*programme->analyser));
+            std::shared_ptr<bw64::AxmlChunk> axml;
+            {
+                common::ScopedTrace trace("xml");
+                axml = createProgrammeAxmlChunk(audioProgramme);
             }
+            axml = std::make_shared<bw64::AxmlChunk>(axml->data() + std::string(AXML_CHUNK_MARGIN, ' '));
 
-            std::string correctedFilePath;
-            std::unique_ptr<bw64::Bw64Writer> correctedFile;
-
-            if(enableCorrection) {
-                // Initialize temporary correction file
-                std::stringstream tempFilePath;
-                tempFilePath << _outputPath << "/";
-                tempFilePath << "adm_loudness_correction_";
-                tempFilePath << audioProgrammeId << "_";
-                tempFilePath << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-                tempFilePath << ".wav";
-                correctedFilePath = tempFilePath.str();
-                correctedFile = bw64::writeFile(correctedFilePath, _renderer.getNbOutputChannels(), _inputFile->sampleRate(), _inputFile->bitDepth());
+            programme->correctedFilePath = outputFilePath.str();
+            programme->correctedFile = bw64::writeFile(programme->correctedFilePath, programme->renderer->getNbOutputChannels(), _inputFile->sampleRate(), _inputFile->bitDepth(), chnaChunk, axml);
+        }
+
+        // Correct all the audio programmes in a second read of the input file
+        try {
+            correctProgrammes(programmes, displayValues, enableLimiter);
+        } catch(const common::ProcessCancelled&) {
+            // no partial output file
+            for(auto& programme : programmes) {
+                programme->correctedFile.reset();
+                std::remove(programme->correctedFilePath.c_str());
             }
+            throw;
+        }
+    }
+
+    for(auto& programme : programmes) {
+        std::shared_ptr<adm::AudioProgramme> audioProgramme = programme->audioProgramme;
+        const adm::LoudnessMetadata loudnessMetadata = getLoudnessMetadata(
+            enableCorrection ? *programme->analyserAfterCorrection : *programme->analyser);
 
-            // Initialize audio programme loudness
-            std::cout << "### Render audio programme: " << admengine::toString(audioProgramme) << std::endl;
-            _renderer.initAudioProgrammeRendering(audioProgramme);
-            const adm::LoudnessMetadata loudnessMetadata = analyseLoudness(displayValues, correctedFile, enableLimiter);
-
-            // Update audio programme
-            admDocument->remove(audioProgramme);
-            audioProgramme->set(loudnessMetadata);
-            admDocument->add(audioProgramme);
-
-            if(correctedFile) {
-                // Create output ADM document
-                std::shared_ptr<adm::Document> outputAdmDocument = adm::Document::create();
-                admengine::copyAudioProgramme(outputAdmDocument, audioProgramme);
-
-                const std::string programmeTitle = admengine::replaceSpecialCharacters(audioProgramme->get<adm::AudioProgrammeName>().get());
-
-                std::stringstream outputFilePath;
-                outputFilePath << _outputPath << "/";
-                outputFilePath << programmeTitle << "_loudness_corrected.wav";
-                std::cout << "Write corrected output file with updated ADM document: " << outputFilePath.str() << std::endl;
-
-                // in case of correction
-                // close corrected file writer
-                correctedFile.reset();
-                // and open a reader on it
-                std::unique_ptr<bw64::Bw64Reader> correctedFileReader = bw64::readFile(correctedFilePath);
-                // Replace ADM document into output file
-                std::shared_ptr<bw64::AxmlChunk> axml = admengine::createAxmlChunk(outputAdmDocument);
-                std::unique_ptr<bw64::Bw64Writer> outputFile = bw64::writeFile(outputFilePath.str(), _renderer.getNbOutputChannels(), _inputFile->sampleRate(), _inputFile->bitDepth(), chnaChunk, axml);
-
-                // transfer data to output file
-                std::vector<float> buffer(admengine::BLOCK_SIZE * correctedFileReader->channels());
-                size_t readFrames = 0;
-                while (!correctedFileReader->eof()) {
-                    readFrames = correctedFileReader->read(&buffer[0], admengine::BLOCK_SIZE);
-                    outputFile->write(&buffer[0], readFrames);
-                }
-
-                // remove temporary file
-                correctedFileReader.reset();
-                if(std::remove(correctedFilePath.c_str())) {
-                    std::stringstream message;
-                    message << "Could not remove temporary file: " << correctedFilePath;
-                    throw std::runtime_error(message.str());
-                }
-                _outputPathsList.push_back(outputFilePath.str());
+        // Update audio programme
+        admDocument->remove(audioProgramme);
+        audioProgramme->set(loudnessMetadata);
+        admDocument->add(audioProgramme);
+
+        if(programme->correctedFile) {
+            // close corrected file writer
+            programme->correctedFile.reset();
+
+            // and replace the reserved ADM document by the one with the corrected loudness
+            common::ScopedStageTimer timer(programme->stats.write, 0, "write");
+            std::shared_ptr<bw64::AxmlChunk> axml;
+            {
+                common::ScopedTrace trace("xml");
+                axml = createProgrammeAxmlChunk(audioProgramme);
             }
+            if(!overwriteAxmlChunk(programme->correctedFilePath, axml->data())) {
+                std::stringstream message;
+                message << "Could not write the ADM document in the axml chunk of file: " << programme->correctedFilePath;
+                throw std::runtime_error(message.str());
+            }
+            _outputPathsList.push_back(programme->correctedFilePath);
+        }
+        _stats += programme->stats;
+    }
+
+    if(!enableCorrection && !_outputPath.empty()) {
+        // Replace ADM document into output file
+        std::shared_ptr<bw64::AxmlChunk> axml;
+        {
+            common::ScopedTrace trace("xml");
+            axml = admengine::createAxmlChunk(admDocument);
         }
+        common::ScopedStageTimer timer(_stats.write, 0, "write");
 
-        if(!enableCorrection && !_outputPath.empty()) {
-            // Replace ADM document into output file
-            std::shared_ptr<bw64::AxmlChunk> axml = admengine::createAxmlChunk(admDocument);
+        // only the metadata change: the audio data is copied by the kernel, without being decoded
+        copyFile(_inputFilePath, _outputPath);
+        if(!replaceAxmlChunk(_outputPath, axml->data())) {
+            // the output file would exceed the size of a RIFF file: rewrite it as a BW64 file
             std::unique_ptr<bw64::Bw64Writer> outputFile = bw64::writeFile(_outputPath, _inputFile->channels(), _inputFile->sampleRate(), _inputFile->bitDepth(), chnaChunk, axml);
 
             size_t readFrames = 0;
@@ -158,157 +212,231 @@ std::shared_ptr<adm::Document> AdmLoudnessAnalyser::process(const bool displayVa
                 readFrames = _inputFile->read(&buffer[0], admengine::BLOCK_SIZE);
                 outputFile->write(&buffer[0], readFrames);
             }
-            _outputPathsList.push_back(_outputPath);
         }
-        return admDocument;
-    } else {
-        throw std::runtime_error("No ADM audio programme found.");
+        timer.setItems(_inputFile->numberOfFrames());
+        _outputPathsList.push_back(_outputPath);
     }
+    return admDocument;
 }
 
-adm::LoudnessMetadata AdmLoudnessAnalyser::analyseLoudness(const bool displayValues,
-                                                           const std::unique_ptr<bw64::Bw64Writer>& correctedFile,
-                                                           const bool enableLimiter) {
-    // Analyse loudness according to EBU R-128
-    Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
-    Loudness::analyser::LoudnessAnalyser analyser(levels);
-
-    // init
-    const size_t nbChannelsToAnalyse = _renderer.getNbOutputChannels();
-    const size_t nbInputChannels = _inputFile->channels();
-    const size_t sampleRate = _inputFile->sampleRate();
-    analyser.initAndStart(nbChannelsToAnalyse, sampleRate);
+std::shared_ptr<bw64::AxmlChunk> AdmLoudnessAnalyser::createProgrammeAxmlChunk(const std::shared_ptr<adm::AudioProgramme>& audioProgramme) {
+    // Create output ADM document
+    std::shared_ptr<adm::Document> outputAdmDocument = adm::Document::create();
+    admengine::copyAudioProgramme(outputAdmDocument, audioProgramme);
+    return admengine::createAxmlChunk(outputAdmDocument);
+}
 
-    // Create interlaced buffer
-    float readFileBuffer[admengine::BLOCK_SIZE * nbInputChannels] = {0.0,}; // nb of samples * nb input channels
+std::unique_ptr<ProgrammeProcess> AdmLoudnessAnalyser::createProgrammeProcess(const std::shared_ptr<adm::AudioProgramme>& audioProgramme,
+                                                                              const bool useMainRenderer) {
+    const std::string audioProgrammeId = formatId(audioProgramme->get<adm::AudioProgrammeId>());
 
-    while (!_inputFile->eof()) {
-        // Read a data block
-        const size_t nbFrames = _inputFile->read(readFileBuffer, admengine::BLOCK_SIZE);
-        if(nbFrames == 0)
-            break;
+    std::unique_ptr<ProgrammeProcess> programme(new ProgrammeProcess());
+    programme->audioProgramme = audioProgramme;
+    programme->gain = 1.f;
 
-        float admRenderBuffer[admengine::BLOCK_SIZE * nbChannelsToAnalyse] = {0.0,}; // nb of samples * nb output channels
-        const size_t renderedSamples = _renderer.processBlock(nbFrames, readFileBuffer, admRenderBuffer);
+    std::shared_ptr<adm::AudioProgramme> rendererAudioProgramme;
+    if(useMainRenderer) {
+        // the renderer which has parsed the document renders the first audio programme
+        programme->renderer = &_renderer;
+        rendererAudioProgramme = audioProgramme;
+    } else {
+        // a renderer per audio programme, so that the programmes can be rendered from the same input block
+        programme->ownRenderer.reset(new admengine::Renderer(_inputFile, _outputLayout, ".", _elementGainsMapping, audioProgrammeId));
+        programme->renderer = programme->ownRenderer.get();
+        for(auto documentAudioProgramme : programme->renderer->getDocumentAudioProgrammes()) {
+            if(formatId(documentAudioProgramme->get<adm::AudioProgrammeId>()) == audioProgrammeId) {
+                rendererAudioProgramme = documentAudioProgramme;
+                break;
+            }
+        }
+        if(!rendererAudioProgramme) {
+            throw std::runtime_error("Audio programme not found: " + audioProgrammeId);
+        }
+    }
+    log("info", "### Render audio programme: " + admengine::toString(audioProgramme));
+    programme->renderer->initAudioProgrammeRendering(rendererAudioProgramme);
 
-        // Create planar buffer of float data
-        float** loudnessInputBuffer = new float*[nbChannelsToAnalyse];
-        convertInterlacedToPlanarBuffer(admRenderBuffer, renderedSamples, loudnessInputBuffer, nbChannelsToAnalyse, nbFrames);
-        analyser.processSamples(loudnessInputBuffer, nbFrames);
+    programme->renderBuffer.resize(admengine::BLOCK_SIZE * programme->renderer->getNbOutputChannels());
+    return programme;
+}
 
-        // free audio buffer
-        delete[] loudnessInputBuffer;
+void AdmLoudnessAnalyser::analyseProgrammes(std::vector<std::unique_ptr<ProgrammeProcess>>& programmes, const bool displayValues,
+                                            const int lastProgress) {
+    for(auto& programme : programmes) {
+        // Analyse loudness according to EBU R-128
+        programme->analyser.reset(new Loudness::analyser::LoudnessAnalyser(_levels));
+        programme->analyser->initAndStart(programme->renderer->getNbOutputChannels(), _inputFile->sampleRate());
+        programme->analyser->reserve(_lastFrame - _firstFrame);
     }
-    _inputFile->seek(0);
 
-    displayResult(analyser.isValidProgram());
-    if(displayValues) {
-        analyser.printPloudValues();
+    processBlocks(programmes, [](ProgrammeProcess& programme, const size_t nbFrames) {
+        programme.analyser->processInterleavedSamples(&programme.renderBuffer[0], nbFrames);
+    }, 0, lastProgress);
+
+    for(auto& programme : programmes) {
+        std::stringstream result;
+        result << "### Audio programme: " << admengine::toString(programme->audioProgramme) << std::endl;
+        displayResult(result, programme->analyser->isValidProgram());
+        if(displayValues) {
+            programme->analyser->printPloudValues(result);
+        }
+        log("info", result.str());
+        programme->stats.analysis += programme->analyser->getStats();
     }
+}
 
-    if(correctedFile) {
-        const float attackMs = 1.0f;  // maximum attack/lookahead time in milliseconds
-        const float releaseMs = 20.0f;    // release time in milliseconds (90% time constant)
+void AdmLoudnessAnalyser::correctProgrammes(std::vector<std::unique_ptr<ProgrammeProcess>>& programmes, const bool displayValues,
+                                            const bool enableLimiter) {
+    const float attackMs = 1.0f;  // maximum attack/lookahead time in milliseconds
+    const float releaseMs = 20.0f;    // release time in milliseconds (90% time constant)
+    const size_t sampleRate = _inputFile->sampleRate();
 
-        float gain = analyser.getCorrectionGain(enableLimiter);
-        std::cout << " => applying correction: gain = " << gain;
-        float threshold = std::pow(10, (levels.truePeakTargetLevel) / 20);
-        std::cout << ", levels.truePeakTargetLevel: " << levels.truePeakTargetLevel;
-        std::cout << ", threshold: " << threshold << std::endl;
+    for(auto& programme : programmes) {
+        const size_t nbChannels = programme->renderer->getNbOutputChannels();
+
+        programme->gain = programme->analyser->getCorrectionGain(enableLimiter);
+        float threshold = std::pow(10, (_levels.truePeakTargetLevel) / 20);
+        std::stringstream correction;
+        correction << "### Audio programme: " << admengine::toString(programme->audioProgramme) << std::endl;
+        correction << " => applying correction: gain = " << programme->gain;
+        correction << ", levels.truePeakTargetLevel: " << _levels.truePeakTargetLevel;
+        correction << ", threshold: " << threshold;
+        log("info", correction.str());
+
+        programme->analyserAfterCorrection.reset(new Loudness::analyser::LoudnessAnalyser(_levels));
+        programme->analyserAfterCorrection->initAndStart(nbChannels, sampleRate);
+        programme->analyserAfterCorrection->reserve(_lastFrame - _firstFrame);
+
+        if(enableLimiter) {
+            programme->peakLimiter.reset(new Loudness::corrector::PeakLimiter(attackMs, releaseMs, threshold, nbChannels, sampleRate));
+            programme->limiterBuffer.resize(admengine::BLOCK_SIZE * nbChannels);
+        }
+    }
 
-        Loudness::analyser::LoudnessAnalyser analyserAfterCorrection(levels);
-        analyserAfterCorrection.initAndStart(nbChannelsToAnalyse, sampleRate);
+    processBlocks(programmes, [this](ProgrammeProcess& programme, const size_t nbFrames) {
+        correctBlock(programme, nbFrames);
+    }, 50, 100);
 
-        // correction with limiter
-        float* writeBuffer = new float[nbChannelsToAnalyse * admengine::BLOCK_SIZE];
+    for(auto& programme : programmes) {
+        std::stringstream result;
+        result << "### Corrected audio programme: " << admengine::toString(programme->audioProgramme) << std::endl;
+        displayResult(result, programme->analyserAfterCorrection->isValidProgram());
+        if(displayValues) {
+            programme->analyserAfterCorrection->printPloudValues(result);
+        }
+        log("info", result.str());
+        programme->stats.analysis += programme->analyserAfterCorrection->getStats();
+    }
+}
 
-        Loudness::corrector::PeakLimiter peakLimiter(attackMs, releaseMs, threshold, nbChannelsToAnalyse, sampleRate);
-        while(true)
-        {
-            // Read a data block
-            const size_t nbFrames = _inputFile->read(readFileBuffer, admengine::BLOCK_SIZE);
-            if(nbFrames == 0)
-                break;
+void AdmLoudnessAnalyser::correctBlock(ProgrammeProcess& programme, const size_t nbFrames) {
+    const size_t nbSamples = nbFrames * programme.renderer->getNbOutputChannels();
 
-            float admRenderBuffer[admengine::BLOCK_SIZE * nbChannelsToAnalyse] = {0.0,}; // nb of samples * nb output channels
-            const size_t renderedSamples = _renderer.processBlock(nbFrames, readFileBuffer, admRenderBuffer);
+    // Correct
+    float* writeBuffer = &programme.renderBuffer[0];
+    {
+        common::ScopedStageTimer timer(programme.stats.correction, nbFrames, "correction");
+        for(size_t i = 0; i < nbSamples; i++)
+            writeBuffer[i] *= programme.gain;
+
+        if(programme.peakLimiter) {
+            // Apply limiter
+            if(programme.peakLimiter->apply(writeBuffer, &programme.limiterBuffer[0], nbFrames)) {
+                log("error", "An error occurred applying limiter");
+            }
+            writeBuffer = &programme.limiterBuffer[0];
+        }
+    }
 
-            // Correct
-            float* inData = &admRenderBuffer[0];
-            float* outData = new float[renderedSamples];
+    // analyse corrected data
+    programme.analyserAfterCorrection->processInterleavedSamples(writeBuffer, nbFrames);
 
-            for(size_t i = 0; i < renderedSamples; i++)
-            {
-                outData[i] = (*inData) * gain;
-                inData++;
-            }
+    {
+        common::ScopedStageTimer timer(programme.stats.write, nbFrames, "write");
+        programme.correctedFile->write(writeBuffer, nbFrames);
+    }
+}
 
-            if(enableLimiter) {
-                // Apply limiter
-                if(peakLimiter.apply(outData, writeBuffer, nbFrames)) {
-                    std::cerr << "An error occurred applying limiter" << std::endl;
-                }
-                delete[] outData;
-            } else {
-                writeBuffer = &outData[0];
-            }
+void AdmLoudnessAnalyser::processBlocks(std::vector<std::unique_ptr<ProgrammeProcess>>& programmes,
+                                        const std::function<void(ProgrammeProcess&, const size_t)>& processBlock,
+                                        const int firstProgress, const int lastProgress) {
+    // Create interlaced buffer (on the heap: a BW64 file can have many channels)
+    _readBuffer.resize(admengine::BLOCK_SIZE * _inputFile->channels());
 
-            // analyse corrected data
-            // Create planar buffer of float data
-            float** loudnessInputBuffer = new float*[nbChannelsToAnalyse];
-            convertInterlacedToPlanarBuffer(writeBuffer, renderedSamples, loudnessInputBuffer, nbChannelsToAnalyse, nbFrames);
-            analyserAfterCorrection.processSamples(loudnessInputBuffer, nbFrames);
+    size_t nbThreads = _nbThreads ? std::min(_nbThreads, programmes.size()) : programmes.size();
+    if(nbThreads <= 1) {
+        // in the calling thread
+        nbThreads = 0;
+    }
+    common::ThreadPool threadPool(nbThreads);
+
+    const size_t totalNbFrames = std::max<size_t>(_lastFrame - _firstFrame, 1);
+    size_t nbFramesProcessed = 0;
+    _inputFile->seek(_firstFrame);
+    while (!_inputFile->eof() && _firstFrame + nbFramesProcessed < _lastFrame) {
+        if(_progressToken) {
+            _progressToken->checkCancellation();
+        }
 
-            // free audio buffer
-            delete[] loudnessInputBuffer;
+        // Read a data block, shared by all the audio programmes
+        const size_t nbFrames = readBlock(&_readBuffer[0], std::min<size_t>(admengine::BLOCK_SIZE, _lastFrame - _firstFrame - nbFramesProcessed));
+        if(nbFrames == 0)
+            break;
 
-            correctedFile->write(writeBuffer, nbFrames);
-            // correctedFile->write(admRenderBuffer, nbFrames);
+        for(auto& programme : programmes) {
+            ProgrammeProcess* programmeProcess = programme.get();
+            threadPool.submit([this, programmeProcess, nbFrames, &processBlock]() {
+                renderBlock(*programmeProcess, nbFrames);
+                processBlock(*programmeProcess, nbFrames);
+            });
         }
-        delete[] writeBuffer;
-        _inputFile->seek(0);
+        // the read buffer is reused by the next block
+        threadPool.wait();
 
-        displayResult(analyserAfterCorrection.isValidProgram());
-        if(displayValues) {
-            analyserAfterCorrection.printPloudValues();
+        nbFramesProcessed += nbFrames;
+        if(_progressToken) {
+            _progressToken->setProgress(firstProgress + (lastProgress - firstProgress) * nbFramesProcessed / totalNbFrames);
         }
-        return getLoudnessMetadata(analyserAfterCorrection);
     }
-    return getLoudnessMetadata(analyser);
+    _inputFile->seek(0);
 }
 
-void AdmLoudnessAnalyser::convertInterlacedToPlanarBuffer(float* interlaced, const size_t nbSamples, float** planar, const size_t nbChannels, const size_t nbFrames) {
-    for (size_t c = 0; c < nbChannels; ++c) {
-        planar[c] = new float[nbFrames];
-    }
+size_t AdmLoudnessAnalyser::readBlock(float* readFileBuffer, const size_t nbFramesToRead) {
+    common::ScopedStageTimer timer(_stats.read, 0, "read");
+    const size_t nbFrames = _inputFile->read(readFileBuffer, nbFramesToRead);
+    timer.setItems(nbFrames);
+    return nbFrames;
+}
 
-    size_t channel_id = 0;
-    size_t frame_id = 0;
-    for (size_t s = 0; s < nbSamples; ++s) {
-        channel_id = s % nbChannels;
-        frame_id = s / nbChannels;
-        planar[channel_id][frame_id] = interlaced[s];
-    }
+size_t AdmLoudnessAnalyser::renderBlock(ProgrammeProcess& programme, const size_t nbFrames) {
+    common::ScopedStageTimer timer(programme.stats.render, nbFrames, "render");
+    return programme.renderer->processBlock(nbFrames, &_readBuffer[0], &programme.renderBuffer[0]);
 }
 
-void AdmLoudnessAnalyser::displayResult(const Loudness::analyser::ELoudnessResult& result) {
-    std::cout << "Program loudness: ";
+void AdmLoudnessAnalyser::displayResult(std::ostream& os, const Loudness::analyser::ELoudnessResult& result) {
+    os << "Program loudness: ";
     switch(result) {
         case Loudness::analyser::ELoudnessResult::eValidResult:
-            std::cout << "Valid" << std::endl;
+            os << "Valid" << std::endl;
             break;
         case Loudness::analyser::ELoudnessResult::eNotValidResult:
-            std::cout << "Invalid" << std::endl;
+            os << "Invalid" << std::endl;
             break;
         case Loudness::analyser::ELoudnessResult::eNotValidResultButNotIllegal:
-            std::cout << "Invalid but legal" << std::endl;
+            os << "Invalid but legal" << std::endl;
             break;
         case Loudness::analyser::ELoudnessResult::eNoImportance:
-            std::cout << "No importance (according to the specification)" << std::endl;
+            os << "No importance (according to the specification)" << std::endl;
             break;
     }
 }
 
+void AdmLoudnessAnalyser::log(const std::string& level, const std::string& message) const {
+    // a message is a block of lines, without the last line feeds
+    const size_t end = message.find_last_not_of('\n');
+    _logger(level, message.substr(0, end == std::string::npos ? 0 : end + 1));
+}
+
 adm::LoudnessMetadata AdmLoudnessAnalyser::getLoudnessMetadata(Loudness::analyser::LoudnessAnalyser& analyser) {
     adm::LoudnessMetadata loudnessMetadata;
     loudnessMetadata.set(adm::LoudnessMethod("ITU-R BS.1770"));
@@ -4,6 +4,12 @@
 #include <adm_engine/renderer.hpp>
 
 #include <loudnessAnalyser/LoudnessAnalyser.hpp>
+#include <loudnessCorrector/PeakLimiter.hpp>
+#include <loudnessCommon/Instrumentation.hpp>
+#include <loudnessCommon/ProgressToken.hpp>
+
+#include <functional>
+#include <memory>
 
 namespace Loudness
 {
@@ -16,6 +22,64 @@ enum EPathType {
     directory
 };
 
+/**
+ * Receiver of the messages of the analysis, with their level: "debug", "info", "warn" or "error".
+ * It is called by the threads of the analysis: a logger shared by several analysers must be thread-safe.
+ */
+typedef std::function<void(const std::string& level, const std::string& message)> AdmLogger;
+
+/**
+ * Time spent in each stage of the processing of all the audio programmes (the items are frames).
+ */
+struct AdmStats {
+    common::StageStats read;          ///< read of the input file
+    common::StageStats render;        ///< rendering of the audio programme
+    common::StageStats correction;    ///< gain and limiter of the correction
+    common::StageStats write;         ///< write of the corrected and of the output files
+    analyser::AnalyserStats analysis; ///< analysis of the rendered and of the corrected samples
+
+    AdmStats& operator+=(const AdmStats& other) {
+        read += other.read;
+        render += other.render;
+        correction += other.correction;
+        write += other.write;
+        analysis += other.analysis;
+        return *this;
+    }
+
+    void print(std::ostream& os) const {
+        os << "ADM stats:" << std::endl;
+        common::printStageStats(os, "read", read);
+        common::printStageStats(os, "render", render);
+        common::printStageStats(os, "correction", correction);
+        common::printStageStats(os, "write", write);
+        analysis.print(os);
+        os << std::endl;
+    }
+};
+
+/**
+ * Rendering, analysis and correction of an audio programme.
+ * Each audio programme has its own renderer: all of them are processed in a single read of the input file.
+ */
+struct ProgrammeProcess {
+    std::shared_ptr<adm::AudioProgramme> audioProgramme; ///< in the document to update
+    admengine::Renderer* renderer;                    ///< renderer of the audio programme
+    std::unique_ptr<admengine::Renderer> ownRenderer; ///< if the renderer of the analyser renders another programme
+    std::vector<float> renderBuffer;  ///< interleaved rendered channels of the current block
+    std::vector<float> limiterBuffer; ///< interleaved rendered channels after the limiter
+
+    std::unique_ptr<analyser::LoudnessAnalyser> analyser;
+    std::unique_ptr<analyser::LoudnessAnalyser> analyserAfterCorrection;
+    std::unique_ptr<corrector::PeakLimiter> peakLimiter;
+    float gain;
+
+    std::string correctedFilePath; ///< output file of the correction
+    std::unique_ptr<bw64::Bw64Writer> correctedFile;
+
+    AdmStats stats; ///< of this audio programme only, it can be processed by another thread
+};
+
 class AdmLoudnessAnalyser {
 public:
     AdmLoudnessAnalyser(const std::string& inputFilePath,
@@ -27,24 +91,80 @@ public:
     std::shared_ptr<adm::Document> process(const bool displayValues, const bool enableCorrection, const bool enableLimiter = true);
     static EPathType getPathType(const std::string& path);
     std::vector<std::string> getOutputPaths() { return _outputPathsList; }
+    const AdmStats& getStats() const { return _stats; }
+
+    /**
+     * Number of threads which render, analyse and correct the audio programmes of each block in parallel.
+     * 1 by default (the calling thread), 0 for a thread per audio programme.
+     */
+    void setNbThreads(const size_t nbThreads) { _nbThreads = nbThreads; }
+
+    /**
+     * Messages of the analysis are written on the standard outputs by default.
+     */
+    void setLogger(const AdmLogger& logger) { _logger = logger; }
+
+    /**
+     * The progress of process() is reported to the token, in percent of the analysis and correction passes.
+     * If the token is cancelled, process() stops at the next block and throws a ProcessCancelled exception.
+     */
+    void setProgressToken(common::ProgressToken* token) { _progressToken = token; }
+
+    /**
+     * Process only the frames of the range: the input file is sought to its first frame, and read up to its last one.
+     * The renderers start their rendering at the first frame of the range.
+     * \param firstFrame first frame of the range
+     * \param lastFrame frame after the end of the range, 0 for the end of the file
+     */
+    void setRange(const size_t firstFrame, const size_t lastFrame = 0);
+    size_t getSampleRate() const { return _inputFile->sampleRate(); }
+
 private:
-    adm::LoudnessMetadata analyseLoudness(const bool displayValues,
-                                          const std::unique_ptr<bw64::Bw64Writer>& outputFile,
-                                          const bool enableLimiter);
+    std::shared_ptr<bw64::AxmlChunk> createProgrammeAxmlChunk(const std::shared_ptr<adm::AudioProgramme>& audioProgramme);
+    std::unique_ptr<ProgrammeProcess> createProgrammeProcess(const std::shared_ptr<adm::AudioProgramme>& audioProgramme,
+                                                             const bool useMainRenderer);
+
+    void analyseProgrammes(std::vector<std::unique_ptr<ProgrammeProcess>>& programmes, const bool displayValues,
+                           const int lastProgress);
+    void correctProgrammes(std::vector<std::unique_ptr<ProgrammeProcess>>& programmes, const bool displayValues,
+                           const bool enableLimiter);
+    void correctBlock(ProgrammeProcess& programme, const size_t nbFrames);
 
-    void convertInterlacedToPlanarBuffer(float* interlaced, const size_t nbSamples, float** planar, const size_t nbChannels, const size_t nbFrames);
-    void displayResult(const Loudness::analyser::ELoudnessResult& result);
+    // read the whole input file once: each block is rendered and processed by all the audio programmes
+    void processBlocks(std::vector<std::unique_ptr<ProgrammeProcess>>& programmes,
+                       const std::function<void(ProgrammeProcess&, const size_t)>& processBlock,
+                       const int firstProgress, const int lastProgress);
+
+    // read and render a block of the input file, timed in the stats
+    size_t readBlock(float* readFileBuffer, const size_t nbFramesToRead);
+    size_t renderBlock(ProgrammeProcess& programme, const size_t nbFrames);
+
+    void displayResult(std::ostream& os, const Loudness::analyser::ELoudnessResult& result);
+    void log(const std::string& level, const std::string& message) const;
     adm::LoudnessMetadata getLoudnessMetadata(Loudness::analyser::LoudnessAnalyser& analyser);
 
 private:
     const std::string _inputFilePath;
     const std::unique_ptr<bw64::Bw64Reader> _inputFile;
+    const std::string _outputLayout;
+    const std::map<std::string, float> _elementGainsMapping;
     admengine::Renderer _renderer;
 
     const std::string _outputPath;
     const std::string _audioProgrammeIdToRender;
 
     std::vector<std::string> _outputPathsList;
+
+    analyser::LoudnessLevels _levels;
+    size_t _nbThreads;
+    size_t _firstFrame; ///< range to process
+    size_t _lastFrame;  ///< excluded
+    AdmLogger _logger;
+    common::ProgressToken* _progressToken;
+
+    std::vector<float> _readBuffer; ///< interleaved input channels, shared by all the audio programmes
+
+    AdmStats _stats;
 };
 
 }
@@ -0,0 +1,239 @@
+
+#include "RiffChunks.hpp"
+
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Loudness
+{
+
+namespace admanalyser
+{
+
+namespace
+{
+
+const uint32_t undefinedSize = 0xFFFFFFFF; // 32 bits size of a chunk which has its size in the ds64 chunk
+
+std::string readId(std::istream& stream) {
+    char id[4];
+    stream.read(id, 4);
+    return std::string(id, 4);
+}
+
+uint64_t readLittleEndian(std::istream& stream, const size_t nbBytes) {
+    unsigned char bytes[8];
+    stream.read(reinterpret_cast<char*>(bytes), nbBytes);
+    uint64_t value = 0;
+    for(size_t i = nbBytes; i > 0; i--) {
+        value = (value << 8) | bytes[i - 1];
+    }
+    return value;
+}
+
+void writeLittleEndian(std::ostream& stream, uint64_t value, const size_t nbBytes) {
+    unsigned char bytes[8];
+    for(size_t i = 0; i < nbBytes; i++) {
+        bytes[i] = value & 0xFF;
+        value >>= 8;
+    }
+    stream.write(reinterpret_cast<const char*>(bytes), nbBytes);
+}
+
+}
+
+std::vector<RiffChunk> listRiffChunks(std::istream& stream) {
+    stream.seekg(0, std::ios::end);
+    const uint64_t fileSize = stream.tellg();
+    stream.seekg(0);
+
+    const std::string riffId = readId(stream);
+    readLittleEndian(stream, 4);
+    const std::string format = readId(stream);
+    if(!stream || (riffId != "RIFF" && riffId != "RF64" && riffId != "BW64") || format != "WAVE") {
+        throw std::runtime_error("Not a RIFF/WAVE file.");
+    }
+
+    // 64 bits sizes of the ds64 chunk, by chunk id
+    std::map<std::string, uint64_t> ds64Sizes;
+
+    std::vector<RiffChunk> chunks;
+    uint64_t position = 12;
+    while(position + 8 <= fileSize) {
+        stream.seekg(position);
+        RiffChunk chunk;
+        chunk.id = readId(stream);
+        chunk.size = readLittleEndian(stream, 4);
+        chunk.dataOffset = position + 8;
+        if(!stream) {
+            break;
+        }
+
+        if(chunk.id == "ds64") {
+            readLittleEndian(stream, 8); // RIFF size
+            ds64Sizes["data"] = readLittleEndian(stream, 8);
+            readLittleEndian(stream, 8); // number of samples
+            const uint64_t tableLength = readLittleEndian(stream, 4);
+            for(uint64_t i = 0; i < tableLength && stream; i++) {
+                const std::string id = readId(stream);
+                ds64Sizes[id] = readLittleEndian(stream, 8);
+            }
+        } else if(chunk.size == undefinedSize && ds64Sizes.count(chunk.id)) {
+            chunk.size = ds64Sizes[chunk.id];
+        }
+        chunks.push_back(chunk);
+
+        // chunks are aligned on 2 bytes
+        position = chunk.dataOffset + chunk.size + (chunk.size & 1);
+    }
+    stream.clear();
+    return chunks;
+}
+
+bool overwriteAxmlChunk(const std::string& filePath, const std::string& xml) {
+    std::fstream file(filePath.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if(!file) {
+        throw std::runtime_error("Could not open file: " + filePath);
+    }
+
+    for(const RiffChunk& chunk : listRiffChunks(file)) {
+        if(chunk.id != "axml") {
+            continue;
+        }
+        if(xml.size() > chunk.size) {
+            return false;
+        }
+        file.seekp(chunk.dataOffset);
+        file.write(xml.data(), xml.size());
+        // whitespace after the root element keeps the XML well-formed
+        const std::string padding(chunk.size - xml.size(), ' ');
+        file.write(padding.data(), padding.size());
+        file.flush();
+        if(!file) {
+            throw std::runtime_error("Could not write the axml chunk of file: " + filePath);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool replaceAxmlChunk(const std::string& filePath, const std::string& xml) {
+    if(overwriteAxmlChunk(filePath, xml)) {
+        return true;
+    }
+
+    std::fstream file(filePath.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if(!file) {
+        throw std::runtime_error("Could not open file: " + filePath);
+    }
+    const std::vector<RiffChunk> chunks = listRiffChunks(file);
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = file.tellg();
+    file.seekg(0);
+    const std::string riffId = readId(file);
+
+    // the new axml chunk is appended, or replaces the existing one if it is the last chunk
+    uint64_t axmlChunkOffset = fileSize + (fileSize & 1);
+    const RiffChunk* previousAxmlChunk = NULL;
+    const RiffChunk* ds64Chunk = NULL;
+    for(const RiffChunk& chunk : chunks) {
+        if(chunk.id == "axml") {
+            previousAxmlChunk = &chunk;
+        } else if(chunk.id == "ds64") {
+            ds64Chunk = &chunk;
+        }
+    }
+    // the last chunk ends with its padding byte if its size is odd
+    if(previousAxmlChunk &&
+       previousAxmlChunk->dataOffset + previousAxmlChunk->size + (previousAxmlChunk->size & 1) >= fileSize) {
+        axmlChunkOffset = previousAxmlChunk->dataOffset - 8;
+        previousAxmlChunk = NULL;
+    }
+
+    const uint64_t riffSize = axmlChunkOffset + 8 + xml.size() + (xml.size() & 1) - 8;
+    if(!ds64Chunk && (riffId != "RIFF" || riffSize >= undefinedSize)) {
+        return false;
+    }
+
+    if(previousAxmlChunk) {
+        // the reader skips the previous XML
+        file.seekp(previousAxmlChunk->dataOffset - 8);
+        file.write("JUNK", 4);
+    }
+
+    file.seekp(axmlChunkOffset);
+    file.write("axml", 4);
+    writeLittleEndian(file, xml.size(), 4);
+    file.write(xml.data(), xml.size());
+    if(xml.size() & 1) {
+        file.put('\0');
+    }
+
+    if(ds64Chunk) {
+        file.seekp(ds64Chunk->dataOffset);
+        writeLittleEndian(file, riffSize, 8);
+    } else {
+        file.seekp(4);
+        writeLittleEndian(file, riffSize, 4);
+    }
+    file.flush();
+    if(!file) {
+        throw std::runtime_error("Could not write the axml chunk of file: " + filePath);
+    }
+    return true;
+}
+
+void copyFile(const std::string& inputFilePath, const std::string& outputFilePath) {
+    struct stat inputStat;
+    struct stat outputStat;
+    if(stat(inputFilePath.c_str(), &inputStat)) {
+        throw std::runtime_error("Could not open file: " + inputFilePath);
+    }
+    if(stat(outputFilePath.c_str(), &outputStat) == 0 && inputStat.st_dev == outputStat.st_dev &&
+       inputStat.st_ino == outputStat.st_ino) {
+        return;
+    }
+
+#ifdef __linux__
+    const int inputFd = open(inputFilePath.c_str(), O_RDONLY);
+    const int outputFd = open(outputFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    off_t remaining = inputStat.st_size;
+    if(inputFd >= 0 && outputFd >= 0) {
+        while(remaining > 0) {
+            const ssize_t copied = copy_file_range(inputFd, NULL, outputFd, NULL, remaining, 0);
+            if(copied <= 0) {
+                break;
+            }
+            remaining -= copied;
+        }
+    }
+    if(inputFd >= 0) {
+        close(inputFd);
+    }
+    if(outputFd >= 0) {
+        close(outputFd);
+    }
+    if(inputFd >= 0 && outputFd >= 0 && remaining == 0) {
+        return;
+    }
+    // not supported between these file systems: copy in user space
+#endif
+
+    std::ifstream input(inputFilePath.c_str(), std::ios::binary);
+    std::ofstream output(outputFilePath.c_str(), std::ios::binary | std::ios::trunc);
+    output << input.rdbuf();
+    if(!input || !output) {
+        throw std::runtime_error("Could not copy file " + inputFilePath + " to " + outputFilePath);
+    }
+}
+
+}
+
+}
@@ -0,0 +1,53 @@
+#ifndef ADM_LOUDNESS_RIFF_CHUNKS_HPP
+#define ADM_LOUDNESS_RIFF_CHUNKS_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Loudness
+{
+namespace admanalyser
+{
+
+/**
+ * Chunk of a RIFF/RF64/BW64 file.
+ */
+struct RiffChunk {
+    std::string id;       ///< four characters code
+    uint64_t dataOffset;  ///< position of the chunk data in the file (after its header)
+    uint64_t size;        ///< size of the chunk data (the 64 bits size of the ds64 chunk if any)
+};
+
+/**
+ * List the chunks of a RIFF/RF64/BW64 file.
+ * Throw a runtime_error if the stream is not a RIFF file.
+ */
+std::vector<RiffChunk> listRiffChunks(std::istream& stream);
+
+/**
+ * Replace the content of the axml chunk of a BW64 file, without moving the other chunks.
+ * The XML is padded with spaces up to the size of the existing chunk.
+ * \return false if the file has no axml chunk or if the XML does not fit in it
+ */
+bool overwriteAxmlChunk(const std::string& filePath, const std::string& xml);
+
+/**
+ * Replace the content of the axml chunk of a BW64 file, without rewriting its audio data.
+ * The chunk is overwritten if the XML fits in it. Otherwise the existing chunk becomes a JUNK chunk
+ * (or is truncated if it is the last one), and a new axml chunk is appended to the file.
+ * \return false if the file cannot grow (RIFF file of more than 4 GiB)
+ */
+bool replaceAxmlChunk(const std::string& filePath, const std::string& xml);
+
+/**
+ * Copy a file in the kernel (copy_file_range, which can share the blocks of the file system) when it is possible.
+ * Nothing is done if both paths are the same file.
+ */
+void copyFile(const std::string& inputFilePath, const std::string& outputFilePath);
+
+}
+}
+
+#endif
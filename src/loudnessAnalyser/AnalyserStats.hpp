@@ -0,0 +1,45 @@
+#ifndef _LOUDNESS_ANALYSER_ANALYSER_STATS_HPP_
+#define _LOUDNESS_ANALYSER_ANALYSER_STATS_HPP_
+
+#include <loudnessCommon/Instrumentation.hpp>
+
+namespace Loudness
+{
+namespace analyser
+{
+
+/**
+ * Time spent in each stage of the loudness analysis (see LoudnessAnalyser::getStats).
+ * The items are samples of one channel for process, and samples of all channels for filter and truePeak.
+ **/
+struct AnalyserStats
+{
+    common::StageStats process;   ///< LoudnessAnalyser::processSamples (includes filter, truePeak and fragments)
+    common::StageStats filter;    ///< K-weighting filters and power of the channels
+    common::StageStats truePeak;  ///< TruePeak meters (oversampling, or lazy evaluation)
+    common::StageStats fragments; ///< Loudness::addFragment of the momentary, short-term and program measures
+    common::StageStats histogram; ///< integrated loudness and loudness range computed from the histograms
+
+    AnalyserStats& operator+=(const AnalyserStats& other)
+    {
+        process += other.process;
+        filter += other.filter;
+        truePeak += other.truePeak;
+        fragments += other.fragments;
+        histogram += other.histogram;
+        return *this;
+    }
+
+    void print(std::ostream& os) const
+    {
+        common::printStageStats(os, "process", process);
+        common::printStageStats(os, "  filter", filter);
+        common::printStageStats(os, "  true peak", truePeak);
+        common::printStageStats(os, "  fragments", fragments);
+        common::printStageStats(os, "histogram", histogram);
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,35 @@
+#include "BasicProcess.hpp"
+
+#include <algorithm>
+
+namespace Loudness
+{
+namespace analyser
+{
+
+#include "BasicProcess.tcc"
+
+template class BasicProcess<0, float>;
+template class BasicProcess<1, float>;
+template class BasicProcess<2, float>;
+template class BasicProcess<5, float>;
+template class BasicProcess<7, float>;
+
+ChannelsProcess* createChannelsProcess(const size_t numberOfChannels)
+{
+    switch(numberOfChannels)
+    {
+        case 1:
+            return new BasicProcess<1, float>();
+        case 2:
+            return new BasicProcess<2, float>();
+        case 5:
+            return new BasicProcess<5, float>();
+        case 7:
+            return new BasicProcess<7, float>();
+        default:
+            return new BasicProcess<0, float>(numberOfChannels);
+    }
+}
+}
+}
@@ -0,0 +1,126 @@
+#ifndef _LOUDNESS_ANALYSER_BASIC_PROCESS_HPP_
+#define _LOUDNESS_ANALYSER_BASIC_PROCESS_HPP_
+
+#include <loudnessCommon/common.hpp>
+#include "Filter.hpp"
+#include "TruePeakMeter.hpp"
+#include "AnalyserStats.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+namespace Loudness
+{
+namespace analyser
+{
+
+/**
+ * Per-channel part of the Process: the K-weighting filters and the TruePeak meters of each channel.
+ * It computes the weighted power and the TruePeak of a block of samples.
+ * The implementation is specialised on the channel layout (see BasicProcess and createChannelsProcess).
+ **/
+class ChannelsProcess
+{
+public:
+    virtual ~ChannelsProcess() {}
+
+    virtual size_t getNbChannels() const = 0;
+
+    virtual void init(const float frequencySampling, const size_t upsamplingFrequency, const ETruePeakFilter filter,
+                      const bool enableOptimization) = 0;
+
+    // reset the states of the filters
+    virtual void reset() = 0;
+
+    // reset the TruePeak of the current period
+    virtual void resetTruePeakMaxValue() = 0;
+
+    // TruePeak of the current period, over all channels
+    virtual float getTruePeakValue() = 0;
+
+    /**
+     * Filter a block of samples (in a fragment) and compute its TruePeak.
+     * \param inputData data for each channel ( data[channel][sampleTime] )
+     * \param truePeakValue max value of the current period, over all channels
+     * \param gateLevel if lazyTruePeak, skip the oversampling of the blocks which cannot exceed this level
+     * \param stats time spent in the filters and in the TruePeak meters is added to it
+     * \return weighted sum of the power of the channels
+     */
+    virtual float detectProcess(float* const* inputData, const size_t nbSamples, float& truePeakValue,
+                                const double gateLevel, const bool lazyTruePeak, AnalyserStats& stats) = 0;
+};
+
+/**
+ * Process of a fixed number of channels: the channel loops and the channel weights are constants.
+ * \tparam Channels number of channels, 0 for a number of channels set at runtime
+ * \tparam Sample type of the input samples
+ **/
+template <size_t Channels, typename Sample>
+class BasicProcess : public ChannelsProcess
+{
+public:
+    explicit BasicProcess(const size_t numberOfChannels = Channels);
+
+    size_t getNbChannels() const { return Channels ? Channels : _numberOfChannels; }
+
+    void init(const float frequencySampling, const size_t upsamplingFrequency, const ETruePeakFilter filter,
+              const bool enableOptimization);
+    void reset();
+    void resetTruePeakMaxValue();
+    float getTruePeakValue();
+
+    float detectProcess(float* const* inputData, const size_t nbSamples, float& truePeakValue, const double gateLevel,
+                        const bool lazyTruePeak, AnalyserStats& stats);
+
+private:
+    /**
+     * Weight of each channel (ITU-R BS.1770-4): 2 for mono channel, 1.41 for surround channels (60 to 120 degrees),
+     * 0 for the LFE, 1 for others.
+     * There is no layout description, so the layout is given by the number of channels:
+     * - up to 5 channels: L, R, C, Ls, Rs (the LFE of a 5.1 file is not read)
+     * - 7 channels: L, R, C, Lss, Rss, Lrs, Rrs (7.1 without LFE)
+     * - 6 channels and more: an ITU-R BS.2051 render, as output by the ADM renderer. L, R, C, LFE, then the surround
+     * channels of the middle layer (0+5+0, 2+5+0, 4+5+0, 4+5+1, 0+7+0, 4+7+0), then rear and upper channels.
+     * The channels of 3+7+0 and 9+10+3 are not in this order.
+     **/
+    float getChannelGain(const size_t channel) const
+    {
+        const size_t nbChannels = getNbChannels();
+        if(nbChannels == 1)
+            return 2.0f;
+        if(nbChannels <= 5 || nbChannels == 7)
+            return channel == 3 || channel == 4 ? 1.41f : 1.0f;
+        if(channel == 3)
+            return 0.0f;
+        return channel == 4 || channel == 5 ? 1.41f : 1.0f;
+    }
+
+    // \return power of the filtered samples of the channel
+    float filterChannel(const size_t channel, const Sample* sampleData, const size_t nbSamples);
+
+    void truePeakChannel(const size_t channel, const Sample* sampleData, const size_t nbSamples, float& truePeakValue,
+                         double& gateLevel, const bool lazyTruePeak);
+
+private:
+    const size_t _numberOfChannels;
+
+    // pre-filters
+    std::vector<Filter> _filters;
+
+    // TruePeakMeter
+    std::vector<TruePeakMeter> _truePeakMeter;
+
+    // sample peak and digital silence of each channel in the current block
+    std::vector<float> _blockPeaks;
+    std::vector<char> _silentBlocks;
+};
+
+/**
+ * \return the process specialised for the number of channels: mono, stereo, 5.0 (5.1 without LFE), 7.0 (7.1 without
+ * LFE), or a generic process for the other layouts (see BasicProcess::getChannelGain for their channel weights)
+ **/
+ChannelsProcess* createChannelsProcess(const size_t numberOfChannels);
+}
+}
+
+#endif
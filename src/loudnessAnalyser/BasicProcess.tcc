@@ -0,0 +1,113 @@
+
+template <size_t Channels, typename Sample>
+BasicProcess<Channels, Sample>::BasicProcess(const size_t numberOfChannels)
+    : _numberOfChannels(numberOfChannels)
+    , _filters(getNbChannels())
+    , _truePeakMeter(getNbChannels())
+    , _blockPeaks(getNbChannels())
+    , _silentBlocks(getNbChannels())
+{
+}
+
+template <size_t Channels, typename Sample>
+void BasicProcess<Channels, Sample>::init(const float frequencySampling, const size_t upsamplingFrequency,
+                                          const ETruePeakFilter filter, const bool enableOptimization)
+{
+    for(size_t channel = 0; channel < getNbChannels(); channel++)
+    {
+        _filters[channel].initializeFilterCoefficients(frequencySampling);
+        _truePeakMeter[channel].setUpsamplingFrequencyInHz(upsamplingFrequency);
+        _truePeakMeter[channel].setFilter(filter);
+        _truePeakMeter[channel].initialize(frequencySampling);
+        _truePeakMeter[channel].enableOptimization(enableOptimization);
+    }
+}
+
+template <size_t Channels, typename Sample>
+void BasicProcess<Channels, Sample>::reset()
+{
+    for(size_t channel = 0; channel < getNbChannels(); channel++)
+        _filters[channel].reset();
+}
+
+template <size_t Channels, typename Sample>
+void BasicProcess<Channels, Sample>::resetTruePeakMaxValue()
+{
+    for(size_t channel = 0; channel < getNbChannels(); channel++)
+        _truePeakMeter[channel].resetMaxValue();
+}
+
+template <size_t Channels, typename Sample>
+float BasicProcess<Channels, Sample>::getTruePeakValue()
+{
+    float truePeakValue = 0;
+    for(size_t channel = 0; channel < getNbChannels(); channel++)
+        truePeakValue = std::max(truePeakValue, _truePeakMeter[channel].getTruePeakValue());
+    return truePeakValue;
+}
+
+template <size_t Channels, typename Sample>
+float BasicProcess<Channels, Sample>::detectProcess(float* const* inputData, const size_t nbSamples,
+                                                    float& truePeakValue, const double gateLevel,
+                                                    const bool lazyTruePeak, AnalyserStats& stats)
+{
+    // the filters and the TruePeak meters are independent: each stage is timed once for all channels
+    float sumOfWeightedPowerChannels = 0;
+    {
+        common::ScopedStageTimer timer(stats.filter, nbSamples * getNbChannels());
+        for(size_t channel = 0; channel < getNbChannels(); channel++)
+            sumOfWeightedPowerChannels += getChannelGain(channel) * filterChannel(channel, inputData[channel], nbSamples);
+    }
+    {
+        common::ScopedStageTimer timer(stats.truePeak, nbSamples * getNbChannels());
+        double channelGateLevel = gateLevel;
+        for(size_t channel = 0; channel < getNbChannels(); channel++)
+            truePeakChannel(channel, inputData[channel], nbSamples, truePeakValue, channelGateLevel, lazyTruePeak);
+    }
+    return sumOfWeightedPowerChannels;
+}
+
+template <size_t Channels, typename Sample>
+float BasicProcess<Channels, Sample>::filterChannel(const size_t channel, const Sample* sampleData,
+                                                    const size_t nbSamples)
+{
+    Filter& filter = _filters[channel];
+
+    // digital silence: a settled filter stays at zero, there is no power and no TruePeak to compute
+    _blockPeaks[channel] = _truePeakMeter[channel].computePeak(sampleData, nbSamples);
+    _silentBlocks[channel] = _blockPeaks[channel] < SILENCE_LEVEL && filter.isSettled();
+
+    if(_silentBlocks[channel])
+    {
+        filter.reset();
+        return 0;
+    }
+
+    // process filtering values and their power
+    return filter.processBlock(sampleData, nbSamples);
+}
+
+template <size_t Channels, typename Sample>
+void BasicProcess<Channels, Sample>::truePeakChannel(const size_t channel, const Sample* sampleData,
+                                                     const size_t nbSamples, float& truePeakValue, double& gateLevel,
+                                                     const bool lazyTruePeak)
+{
+    TruePeakMeter& truePeakMeter = _truePeakMeter[channel];
+    const bool silentBlock = _silentBlocks[channel];
+
+    // process the true peak value (with inter-samples)
+    if(!lazyTruePeak && !silentBlock)
+    {
+        for(size_t sample = 0; sample < nbSamples; sample++)
+            truePeakValue = std::max(truePeakValue, truePeakMeter.processSample(sampleData[sample]));
+    }
+
+    if(lazyTruePeak || silentBlock)
+    {
+        // without lazy evaluation, the gate is 0: only a silent window is skipped
+        if(lazyTruePeak)
+            gateLevel = std::max(gateLevel, (double)truePeakValue);
+        truePeakValue = std::max(truePeakValue, truePeakMeter.processBlock(sampleData, nbSamples, _blockPeaks[channel],
+                                                                            lazyTruePeak ? gateLevel : 0.0));
+    }
+}
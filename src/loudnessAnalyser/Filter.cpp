@@ -103,5 +103,33 @@ float Filter::processSample(const float& sample)
     // return the new sampling value
     return filteredChannel;
 }
+
+float Filter::processBlock(const float* samples, const size_t nbSamples)
+{
+    // the memory values stay in registers (the samples could alias them)
+    float z1 = _z1, z2 = _z2, z3 = _z3, z4 = _z4;
+    float sumOfPower = 0;
+
+    for(size_t sample = 0; sample < nbSamples; sample++)
+    {
+        double x = samples[sample] - _preA1 * z1 - _preA2 * z2;
+        double y = _preB0 * x + _preB1 * z1 + _preB2 * z2 - _rlbA1 * z3 - _rlbA2 * z4;
+
+        const float filteredSample = _rlbB0 * y + _rlbB1 * z3 + _rlbB2 * z4;
+        sumOfPower += filteredSample * filteredSample;
+
+        z2 = z1;
+        z1 = x;
+
+        z4 = z3;
+        z3 = y;
+    }
+
+    _z1 = z1;
+    _z2 = z2;
+    _z3 = z3;
+    _z4 = z4;
+    return sumOfPower;
+}
 }
 }
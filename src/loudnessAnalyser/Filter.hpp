@@ -1,6 +1,11 @@
 #ifndef _LOUDNESS_ANALYSER_FILTER_HPP_
 #define _LOUDNESS_ANALYSER_FILTER_HPP_
 
+#include <loudnessCommon/common.hpp>
+
+#include <cmath>
+#include <cstdlib>
+
 namespace Loudness
 {
 namespace analyser
@@ -15,6 +20,19 @@ public:
 
     float processSample(const float& sample);
 
+    /**
+     * Filter a block of samples, as processSample on each sample.
+     * \return sum of the power of the filtered samples
+     */
+    float processBlock(const float* samples, const size_t nbSamples);
+
+    // true if the output of the filter on a silence is negligible (it can be reset instead)
+    bool isSettled() const
+    {
+        return std::abs(_z1) < SILENCE_LEVEL && std::abs(_z2) < SILENCE_LEVEL && std::abs(_z3) < SILENCE_LEVEL &&
+               std::abs(_z4) < SILENCE_LEVEL;
+    }
+
 private:
     float _z1, _z2, _z3, _z4;
 
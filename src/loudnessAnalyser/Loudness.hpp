@@ -40,6 +40,11 @@ public:
      */
     void reset();
 
+    /**
+     * reserve the Short-Term values kept in the temporal history
+     */
+    void reserve(const size_t nbValues) { _temporalValues.reserve(nbValues); }
+
     /**
      * add fragment value
      * a fragment is a loudness value on a windows of 50ms
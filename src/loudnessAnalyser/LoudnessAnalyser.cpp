@@ -2,6 +2,8 @@
 #include "LoudnessAnalyser.hpp"
 #include "Process.hpp"
 
+#include <loudnessCommon/FlushToZero.hpp>
+
 #include <iostream>
 #include <iomanip>
 #include <limits>
@@ -30,12 +32,47 @@ void LoudnessAnalyser::setUpsamplingFrequencyForTruePeak(const size_t frequency)
     p_process->setUpsamplingFrequencyForTruePeak(frequency);
 }
 
+void LoudnessAnalyser::setTruePeakFilter(const ETruePeakFilter filter)
+{
+    p_process->setTruePeakFilter(filter);
+}
+
+void LoudnessAnalyser::enableLazyTruePeak(const bool enable)
+{
+    p_process->enableLazyTruePeak(enable);
+}
+
 void LoudnessAnalyser::processSamples(float** samplesData, const size_t nbSamples)
 {
+    // the filters decay to denormal values after each end of signal
+    common::ScopedFlushToZero flushToZero;
+    common::ScopedStageTimer timer(p_process->getStats().process, nbSamples, "analyse");
     s_durationInSamples += nbSamples;
     p_process->process(nbSamples, samplesData);
 }
 
+void LoudnessAnalyser::processInterleavedSamples(const float* samplesData, const size_t nbSamples)
+{
+    common::ScopedFlushToZero flushToZero;
+    common::ScopedStageTimer timer(p_process->getStats().process, nbSamples, "analyse");
+    s_durationInSamples += nbSamples;
+    p_process->processInterleaved(nbSamples, samplesData);
+}
+
+void LoudnessAnalyser::processInterleavedPcmSamples(const unsigned char* samplesData, const size_t nbSamples,
+                                                    const EPcmFormat format)
+{
+    common::ScopedFlushToZero flushToZero;
+    common::ScopedStageTimer timer(p_process->getStats().process, nbSamples, "analyse");
+    s_durationInSamples += nbSamples;
+    p_process->processInterleavedPcm(nbSamples, samplesData, format); // the format is the number of bytes per sample
+}
+
+void LoudnessAnalyser::reserve(const size_t durationInSamples)
+{
+    p_process->reserve(durationInSamples);
+}
+
 bool LoudnessAnalyser::isShortProgram()
 {
     return (s_durationInSamples < s_frequency * 120);
@@ -81,27 +118,38 @@ double LoudnessAnalyser::getTruePeakInDbTP()
     return p_process->getTruePeakValueInDb();
 }
 
-void LoudnessAnalyser::printPloudValues()
-{
-    std::cout.precision(1);
-    std::cout.setf(std::ios::fixed, std::ios::floatfield);
-    std::cout << "Integrated (Program Loudness) = " << p_process->getIntegrated() << " LUFS" << std::endl;
-    std::cout << "       Integrated range (LRA) = " << p_process->getRangeMax() - p_process->getRangeMin() << " LU"
-              << std::endl;
-    std::cout << "                max Momentary = " << p_process->getMaxLoudnessMomentary() << " LUFS" << std::endl;
-    std::cout << "               max Short-Term = " << p_process->getMaxLoudnessShortTerm() << " LUFS" << std::endl;
-    std::cout << "               min Short-Term = " << p_process->getMinLoudnessShortTerm() << " LUFS" << std::endl;
-    std::cout.precision(6);
-    std::cout << "                    true peak = " << p_process->getTruePeakValue() << " ( ";
-    std::cout.precision(1);
-    std::cout << p_process->getTruePeakValueInDb() << " dBFS )" << std::endl;
-    std::cout << std::endl;
-    std::cout << "         Integrated threshold = " << p_process->getIntegratedThreshold() << " LUFS" << std::endl;
-    std::cout << "              Range threshold = " << p_process->getRangeThreshold() << " LUFS" << std::endl;
-
-    std::cout << "                    range min = " << p_process->getRangeMin() << " LUFS" << std::endl;
-    std::cout << "                    range max = " << p_process->getRangeMax() << " LUFS" << std::endl;
-    std::cout << std::endl;
+void LoudnessAnalyser::printPloudValues(std::ostream& os)
+{
+    os.precision(1);
+    os.setf(std::ios::fixed, std::ios::floatfield);
+    os << "Integrated (Program Loudness) = " << p_process->getIntegrated() << " LUFS" << std::endl;
+    os << "       Integrated range (LRA) = " << p_process->getRangeMax() - p_process->getRangeMin() << " LU" << std::endl;
+    os << "                max Momentary = " << p_process->getMaxLoudnessMomentary() << " LUFS" << std::endl;
+    os << "               max Short-Term = " << p_process->getMaxLoudnessShortTerm() << " LUFS" << std::endl;
+    os << "               min Short-Term = " << p_process->getMinLoudnessShortTerm() << " LUFS" << std::endl;
+    os.precision(6);
+    os << "                    true peak = " << p_process->getTruePeakValue() << " ( ";
+    os.precision(1);
+    os << p_process->getTruePeakValueInDb() << " dBFS )" << std::endl;
+    os << std::endl;
+    os << "         Integrated threshold = " << p_process->getIntegratedThreshold() << " LUFS" << std::endl;
+    os << "              Range threshold = " << p_process->getRangeThreshold() << " LUFS" << std::endl;
+
+    os << "                    range min = " << p_process->getRangeMin() << " LUFS" << std::endl;
+    os << "                    range max = " << p_process->getRangeMax() << " LUFS" << std::endl;
+    os << std::endl;
+}
+
+const AnalyserStats& LoudnessAnalyser::getStats()
+{
+    return p_process->getStats();
+}
+
+void LoudnessAnalyser::printStats(std::ostream& os)
+{
+    os << "Analyser stats:" << std::endl;
+    p_process->getStats().print(os);
+    os << std::endl;
 }
 
 std::vector<float> LoudnessAnalyser::getTruePeakValues()
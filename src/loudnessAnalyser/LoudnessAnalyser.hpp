@@ -2,8 +2,11 @@
 #define _LOUDNESS_ANALYSER_LOUDNESS_ANALYSER_HPP_
 
 #include <loudnessCommon/common.hpp>
+#include "TruePeakFilters.hpp"
+#include "AnalyserStats.hpp"
 
 #include <cstdlib>
+#include <iostream>
 #include <vector>
 #include <memory>
 #include <limits>
@@ -23,6 +26,17 @@ enum LoudnessExport EStandard
     eStandardUnknown
 };
 
+/**
+ * Interleaved samples of an uncompressed audio stream: signed integers, little endian.
+ * The value of each format is its number of bytes per sample.
+ */
+enum LoudnessExport EPcmFormat
+{
+    ePcmFormatS16LE = 2,
+    ePcmFormatS24LE = 3,
+    ePcmFormatS32LE = 4
+};
+
 struct LoudnessExport LoudnessLevels
 {
     float programLoudnessLongProgramMaxValue;
@@ -195,6 +209,23 @@ public:
      */
     void setUpsamplingFrequencyForTruePeak(const size_t frequency);
 
+    /**
+     * Select the oversampling filter of the TruePeakMeter (see ETruePeakFilter for the accuracy of each filter).
+     * The legacy filter is used by default, the fast filters trade accuracy for speed.
+     * Call initAndStart() after to set coefficients filters correctly.
+     * \param filter oversampling filter
+     */
+    void setTruePeakFilter(const ETruePeakFilter filter);
+
+    /**
+     * Oversample only the blocks whose sample peak, raised by the worst-case inter-sample overshoot of the filter,
+     * can exceed the current TruePeak of the program.
+     * The TruePeak of the program stays exact, but the TruePeak history values (see getTruePeakValues) are only
+     * lower bounds for the periods under the TruePeak of the program.
+     * \param enable disabled by default
+     */
+    void enableLazyTruePeak(const bool enable = true);
+
     /**
      * Add samples need to be processed
      * \param samplesData data for each channels ( data[channel][sampleTime] )
@@ -202,6 +233,28 @@ public:
     **/
     void processSamples(float** samplesData, const size_t nbSamples);
 
+    /**
+     * Add interleaved samples need to be processed, without a planar copy of the whole buffer
+     * \param samplesData interleaved data of all channels ( data[sampleTime * channels + channel] )
+     * \param samples number of samples per channel in the data pointer
+    **/
+    void processInterleavedSamples(const float* samplesData, const size_t nbSamples);
+
+    /**
+     * Add interleaved PCM samples need to be processed, as they are stored in the uncompressed audio files:
+     * they are scaled to [-1, 1[ while they are deinterleaved, without a float copy of the whole buffer
+     * \param samplesData interleaved samples of all channels, in the given format
+     * \param samples number of samples per channel in the data pointer
+    **/
+    void processInterleavedPcmSamples(const unsigned char* samplesData, const size_t nbSamples, const EPcmFormat format);
+
+    /**
+     * Reserve the history of the program (Short-Term and TruePeak values), so that processSamples does not allocate
+     * memory before this duration is analysed. Call it after initAndStart.
+     * \param durationInSamples expected duration of the program (samples per channel)
+    **/
+    void reserve(const size_t durationInSamples);
+
     /**
      * Return if the program is a Short Program or a Long Program ( > 2'00 )
     **/
@@ -273,9 +326,20 @@ public:
     std::vector<int> getShortTermHistogram();
 
     /**
-     * Print result of Loudness on standard output Integrated, Momentary and Short-Term and LRA
+     * Print result of Loudness on the given stream (standard output by default) Integrated, Momentary and Short-Term and LRA
+    **/
+    void printPloudValues(std::ostream& os = std::cout);
+
+    /**
+     * Get the time spent in each stage of the analysis since initAndStart
+     * (all counters stay at 0 when the library is built with LOUDNESS_DISABLE_INSTRUMENTATION)
+    **/
+    const AnalyserStats& getStats();
+
+    /**
+     * Print the time spent in each stage of the analysis on the given stream (standard output by default)
     **/
-    void printPloudValues();
+    void printStats(std::ostream& os = std::cout);
 
     /**
      * Return if the program is valid
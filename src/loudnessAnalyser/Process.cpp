@@ -1,14 +1,20 @@
 #include "Process.hpp"
+#include "BasicProcess.hpp"
+
+#include <stdint.h>
 
 namespace Loudness
 {
 namespace analyser
 {
 
-float Process::_channelGain[MAX_CHANNELS] = {1.0f, 1.0f, 1.0f, 1.41f, 1.41f};
-
 Process::Process(float absoluteThresholdValue, float relativeThresholdValue)
-    : s_measureLoudness(eCorrectionLoudness, absoluteThresholdValue, relativeThresholdValue, -200, 20, 0.01)
+    : _numberOfChannels(0)
+    , _lazyTruePeak(false)
+    , _upsamplingFrequency(192000)
+    , _truePeakFilter(eTruePeakFilterLegacy)
+    , _channelsProcess(NULL)
+    , s_measureLoudness(eCorrectionLoudness, absoluteThresholdValue, relativeThresholdValue, -200, 20, 0.01)
     , s_shortTermLoudness(eShortTermLoudness, absoluteThresholdValue, relativeThresholdValue)
     , s_momentaryLoudness(eMomentaryLoudness, absoluteThresholdValue, relativeThresholdValue)
 {
@@ -16,6 +22,7 @@ Process::Process(float absoluteThresholdValue, float relativeThresholdValue)
 
 Process::~Process()
 {
+    delete _channelsProcess;
 }
 
 void Process::init(const int numberOfChannels, const float frequencySampling, const bool enableOptimization)
@@ -24,12 +31,18 @@ void Process::init(const int numberOfChannels, const float frequencySampling, co
     _frequencySampling = frequencySampling;
     _fragmentSize = (int)frequencySampling / 20;
 
-    for(size_t channel = 0; channel < _numberOfChannels; channel++)
+    if(!_channelsProcess || _channelsProcess->getNbChannels() != _numberOfChannels)
     {
-        _filters[channel].initializeFilterCoefficients(_frequencySampling);
-        _truePeakMeter[channel].initialize(_frequencySampling);
-        _truePeakMeter[channel].enableOptimization(enableOptimization);
+        delete _channelsProcess;
+        _channelsProcess = createChannelsProcess(_numberOfChannels);
     }
+    _channelsProcess->init(_frequencySampling, _upsamplingFrequency, _truePeakFilter, enableOptimization);
+    _inputPointerData.resize(_numberOfChannels);
+
+    _planarData.resize(_numberOfChannels * _fragmentSize);
+    _planarPointerData.resize(_numberOfChannels);
+    for(size_t channel = 0; channel < _numberOfChannels; channel++)
+        _planarPointerData[channel] = &_planarData[channel * _fragmentSize];
 
     reset();
 }
@@ -44,21 +57,32 @@ void Process::reset()
     _countTruePeakPeriod = 0;
 
     _vectorOfTruePeakValue.clear();
+    _stats = AnalyserStats();
 
-    for(size_t c = 0; c < _numberOfChannels; c++)
-        _filters[c].reset();
+    if(_channelsProcess)
+        _channelsProcess->reset();
 
     s_measureLoudness.reset();
     s_shortTermLoudness.reset();
     s_momentaryLoudness.reset();
 }
 
+void Process::reserve(const size_t nbSamples)
+{
+    // one value of each history every 10 fragments
+    const size_t nbValues = nbSamples / (_fragmentSize * 10) + 1;
+    _vectorOfTruePeakValue.reserve(nbValues);
+    s_shortTermLoudness.reserve(nbValues);
+}
+
 void Process::setUpsamplingFrequencyForTruePeak(const size_t frequency)
 {
-    for(size_t channel = 0; channel < MAX_CHANNELS; channel++)
-    {
-        _truePeakMeter[channel].setUpsamplingFrequencyInHz(frequency);
-    }
+    _upsamplingFrequency = frequency;
+}
+
+void Process::setTruePeakFilter(const ETruePeakFilter filter)
+{
+    _truePeakFilter = filter;
 }
 
 void Process::process(size_t nbSamples, float* inputData[])
@@ -87,13 +111,15 @@ void Process::process(size_t nbSamples, float* inputData[])
                 _truePeakValue = std::max(_truePeakValue, _tmpTruePeakValue);
                 _tmpTruePeakValue = 0.0;
                 _countTruePeakPeriod = 0;
-                for(channel = 0; channel < _numberOfChannels; channel++)
-                    _truePeakMeter[channel].resetMaxValue();
+                _channelsProcess->resetTruePeakMaxValue();
             }
 
-            s_momentaryLoudness.addFragment(_fragmentPower / _fragmentSize);
-            s_shortTermLoudness.addFragment(_fragmentPower / _fragmentSize);
-            s_measureLoudness.addFragment(_fragmentPower / _fragmentSize);
+            {
+                common::ScopedStageTimer timer(_stats.fragments, 1);
+                s_momentaryLoudness.addFragment(_fragmentPower / _fragmentSize);
+                s_shortTermLoudness.addFragment(_fragmentPower / _fragmentSize);
+                s_measureLoudness.addFragment(_fragmentPower / _fragmentSize);
+            }
 
             _fragmentCount = _fragmentSize;
             _fragmentPower = 1e-30f;
@@ -107,42 +133,78 @@ void Process::process(size_t nbSamples, float* inputData[])
     }
 }
 
-float Process::detectProcess(const size_t nbSamples, float& truePeakValue)
+void Process::processInterleaved(size_t nbSamples, const float* inputData)
 {
-    // process on a bloc of 50ms, compute the loudness value, and the found the TruePeak on the buffer
-    size_t channel;
-    size_t sample;
-    float sumOfChannelPower, sumOfWeightedPowerChannels;
-    float filteredChannel;
-    float* sampleData;
-
-    truePeakValue = 0.0; // reset the TruePeak to be sure to take the max value after.
-
-    sumOfWeightedPowerChannels = 0;
-    for(channel = 0; channel < _numberOfChannels; channel++)
+    // deinterleave up to the end of the current fragment, and process it while it is in cache
+    while(nbSamples)
     {
-        sampleData = _inputPointerData[channel];
-        sumOfChannelPower = 0;
+        const size_t samplesForOneBloc = (_fragmentCount < nbSamples) ? _fragmentCount : nbSamples;
 
-        for(sample = 0; sample < nbSamples; sample++)
+        for(size_t sample = 0; sample < samplesForOneBloc; sample++)
         {
-            // process filtering value
-            filteredChannel = _filters[channel].processSample(sampleData[sample]);
+            for(size_t channel = 0; channel < _numberOfChannels; channel++)
+                _planarPointerData[channel][sample] = *inputData++;
+        }
+        process(samplesForOneBloc, &_planarPointerData[0]);
 
-            // process the true peak value (with inter-samples)
-            truePeakValue = std::max(truePeakValue, _truePeakMeter[channel].processSample(sampleData[sample]));
+        nbSamples -= samplesForOneBloc;
+    }
+}
+
+void Process::processInterleavedPcm(size_t nbSamples, const unsigned char* inputData, const size_t nbBytesPerSample)
+{
+    switch(nbBytesPerSample)
+    {
+        case 2:
+            processInterleavedPcm<2>(nbSamples, inputData);
+            break;
+        case 3:
+            processInterleavedPcm<3>(nbSamples, inputData);
+            break;
+        case 4:
+            processInterleavedPcm<4>(nbSamples, inputData);
+            break;
+    }
+}
+
+template <size_t nbBytesPerSample>
+void Process::processInterleavedPcm(size_t nbSamples, const unsigned char* inputData)
+{
+    // the sample is put in the most significant bytes of a 32 bits integer, which keeps its sign
+    const float scale = 1.f / 2147483648.f;
+    while(nbSamples)
+    {
+        const size_t samplesForOneBloc = (_fragmentCount < nbSamples) ? _fragmentCount : nbSamples;
 
-            // process power value of the filtered value
-            sumOfChannelPower += filteredChannel * filteredChannel;
+        for(size_t sample = 0; sample < samplesForOneBloc; sample++)
+        {
+            for(size_t channel = 0; channel < _numberOfChannels; channel++)
+            {
+                uint32_t value = 0;
+                for(size_t byte = 0; byte < nbBytesPerSample; byte++)
+                    value |= (uint32_t)inputData[byte] << (8 * (4 - nbBytesPerSample + byte));
+                _planarPointerData[channel][sample] = (int32_t)value * scale;
+                inputData += nbBytesPerSample;
+            }
         }
+        process(samplesForOneBloc, &_planarPointerData[0]);
 
-        // weight each channel (1.41 for surround channels, 1 for others, 2 for mono channel)
-        if(_numberOfChannels == 1)
-            sumOfWeightedPowerChannels = 2 * sumOfChannelPower;
-        else
-            sumOfWeightedPowerChannels += _channelGain[channel] * sumOfChannelPower;
+        nbSamples -= samplesForOneBloc;
     }
-    return sumOfWeightedPowerChannels;
+}
+
+float Process::detectProcess(const size_t nbSamples, float& truePeakValue)
+{
+    // process on a bloc of 50ms, compute the loudness value, and the found the TruePeak on the buffer
+    truePeakValue = 0.0; // reset the TruePeak to be sure to take the max value after.
+
+    // running TruePeak of the program: lazy evaluation skips the blocks which cannot exceed it
+    double gateLevel = _truePeakValue;
+    if(_lazyTruePeak)
+        gateLevel = std::max(gateLevel, (double)_channelsProcess->getTruePeakValue());
+
+    return _channelsProcess->detectProcess(&_inputPointerData[0], nbSamples, truePeakValue, gateLevel, _lazyTruePeak,
+                                           _stats);
 }
 }
 }
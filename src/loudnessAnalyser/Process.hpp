@@ -3,9 +3,9 @@
 
 #include <loudnessCommon/common.hpp>
 #include "Loudness.hpp"
-#include "Filter.hpp"
 #include "Histogram.hpp"
-#include "TruePeakMeter.hpp"
+#include "TruePeakFilters.hpp"
+#include "AnalyserStats.hpp"
 
 #include <vector>
 #include <cmath>
@@ -16,6 +16,7 @@ namespace analyser
 {
 
 struct LoudnessLevels;
+class ChannelsProcess;
 
 class Process
 {
@@ -23,11 +24,22 @@ public:
     Process(float absoluteThresholdValue, float relativeThresholdValue);
     ~Process();
 
+    // select the ChannelsProcess specialised for the number of channels
     void init(const int numberOfChannels, const float frequencySampling, const bool enableOptimization = true);
     void reset();
     void process(size_t nbSamples, float* inputData[]);
+    void processInterleaved(size_t nbSamples, const float* inputData);
+    // signed little endian integers of 2, 3 or 4 bytes
+    void processInterleavedPcm(size_t nbSamples, const unsigned char* inputData, const size_t nbBytesPerSample);
+
+    // reserve the values kept every 500ms for a program of nbSamples
+    void reserve(const size_t nbSamples);
 
     void setUpsamplingFrequencyForTruePeak(const size_t frequency);
+    void setTruePeakFilter(const ETruePeakFilter filter);
+
+    // skip the oversampling of blocks which cannot raise the TruePeak of the program
+    void enableLazyTruePeak(const bool enable = true) { _lazyTruePeak = enable; }
 
     float getMaxLoudnessMomentary() const { return s_momentaryLoudness.getMaxLoudnessValue(); }
 
@@ -36,6 +48,7 @@ public:
 
     float getIntegrated()
     {
+        common::ScopedStageTimer timer(_stats.histogram, 0, "histogram");
         float _integratedLoudness, _integratedThreshold;
         s_momentaryLoudness.processIntegrationValues(_integratedLoudness, _integratedThreshold);
         return _integratedLoudness;
@@ -43,6 +56,7 @@ public:
 
     float getIntegratedThreshold()
     {
+        common::ScopedStageTimer timer(_stats.histogram, 0, "histogram");
         float _integratedLoudness, _integratedThreshold;
         s_momentaryLoudness.processIntegrationValues(_integratedLoudness, _integratedThreshold);
         return _integratedThreshold;
@@ -50,18 +64,21 @@ public:
 
     float getRangeMin()
     {
+        common::ScopedStageTimer timer(_stats.histogram, 0, "histogram");
         s_shortTermLoudness.processRangeValues();
         return s_shortTermLoudness.getMinRange();
     }
 
     float getRangeMax()
     {
+        common::ScopedStageTimer timer(_stats.histogram, 0, "histogram");
         s_shortTermLoudness.processRangeValues();
         return s_shortTermLoudness.getMaxRange();
     }
 
     float getRangeThreshold()
     {
+        common::ScopedStageTimer timer(_stats.histogram, 0, "histogram");
         s_shortTermLoudness.processRangeValues();
         return s_shortTermLoudness.getThresholdRange();
     }
@@ -81,7 +98,16 @@ public:
         return s_measureLoudness.getCorrectionGain(levels, isShortProgram, getTruePeakValueInDb(), limiterIsEnable);
     }
 
+    AnalyserStats& getStats() { return _stats; }
+
 private:
+    Process(const Process&);
+    Process& operator=(const Process&);
+
+    // deinterleave and scale the PCM samples fragment by fragment
+    template <size_t nbBytesPerSample>
+    void processInterleavedPcm(size_t nbSamples, const unsigned char* inputData);
+
     // process on a bloc of 50ms, compute the loudness value, and found the TruePeak on the buffer
     float detectProcess(const size_t nbSamples, float& truePeakValue);
 
@@ -96,21 +122,23 @@ private:
     int _countTruePeakPeriod;                  // TruePeak counter
     std::vector<float> _vectorOfTruePeakValue; // temporal TruePeak on window size
     float _truePeakValue;                      // TruePeak on Program
+    bool _lazyTruePeak;                        // oversample only blocks close to the TruePeak on Program
+    size_t _upsamplingFrequency;               // TruePeak settings, kept when the channels process is created
+    ETruePeakFilter _truePeakFilter;
 
-    float* _inputPointerData[MAX_CHANNELS];
-    // pre-filters
-    Filter _filters[MAX_CHANNELS];
-
-    // TruePeakMeter
-    TruePeakMeter _truePeakMeter[MAX_CHANNELS];
+    std::vector<float*> _inputPointerData;
+    // planar copy of a fragment of interleaved samples
+    std::vector<float> _planarData;
+    std::vector<float*> _planarPointerData;
+    // pre-filters and TruePeakMeter of each channel
+    ChannelsProcess* _channelsProcess;
 
     Loudness s_measureLoudness;
 
     Loudness s_shortTermLoudness;
     Loudness s_momentaryLoudness;
 
-    // Default channel gains.
-    static float _channelGain[MAX_CHANNELS];
+    AnalyserStats _stats;
 };
 }
 }
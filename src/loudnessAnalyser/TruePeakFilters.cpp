@@ -0,0 +1,119 @@
+#include "TruePeakFilters.hpp"
+
+namespace Loudness
+{
+namespace analyser
+{
+
+// Kaiser windowed sinc (beta = 8), cut-off at the input Nyquist frequency, each phase normalized to a unity gain
+static const float strict2x[] = {
+    // phase 0
+    -3.34240228e-05f, 0.000148984847f, -0.000397506734f, 0.000858697554f, -0.00163683159f, 0.00286348965f,
+    -0.00470167789f, 0.00735414053f, -0.0110816118f, 0.0162431981f, -0.0233871946f, 0.0334669025f, -0.0484131106f,
+    0.0729662915f, -0.122796797f, 0.297572821f, 0.899479259f, -0.175866053f, 0.092649476f, -0.0589632329f,
+    0.0401404489f, -0.0279735474f, 0.0195213021f, -0.0134549313f, 0.00906407376f, -0.00591150969f, 0.00369454771f,
+    -0.00218471093f, 0.00120059962f, -0.0005956069f, 0.000252189826f, -7.86772057e-05f,
+    // phase 1
+    -7.86772057e-05f, 0.000252189826f, -0.0005956069f, 0.00120059962f, -0.00218471093f, 0.00369454771f, -0.00591150969f,
+    0.00906407376f, -0.0134549313f, 0.0195213021f, -0.0279735474f, 0.0401404489f, -0.0589632329f, 0.092649476f,
+    -0.175866053f, 0.899479259f, 0.297572821f, -0.122796797f, 0.0729662915f, -0.0484131106f, 0.0334669025f,
+    -0.0233871946f, 0.0162431981f, -0.0110816118f, 0.00735414053f, -0.00470167789f, 0.00286348965f, -0.00163683159f,
+    0.000858697554f, -0.000397506734f, 0.000148984847f, -3.34240228e-05f
+};
+
+// ITU-R BS.1770-4, annex 2: interpolating filter for a 4 times oversampling
+static const float strict4x[] = {
+    // phase 0
+    0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f, -0.0594482421875f, 0.1373291015625f,
+    0.9721679687500f, -0.1022949218750f, 0.0476074218750f, -0.0266113281250f, 0.0148925781250f, -0.0083007812500f,
+    // phase 1
+    -0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f, -0.1665039062500f, 0.4650878906250f,
+    0.7797851562500f, -0.2003173828125f, 0.1015625000000f, -0.0582275390625f, 0.0330810546875f, -0.0189208984375f,
+    // phase 2
+    -0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f, -0.2003173828125f, 0.7797851562500f,
+    0.4650878906250f, -0.1665039062500f, 0.0891113281250f, -0.0517578125000f, 0.0292968750000f, -0.0291748046875f,
+    // phase 3
+    -0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f, -0.1022949218750f, 0.9721679687500f,
+    0.1373291015625f, -0.0594482421875f, 0.0332031250000f, -0.0196533203125f, 0.0109863281250f, 0.0017089843750f
+};
+
+// Kaiser windowed sinc (beta = 8), cut-off at the input Nyquist frequency, each phase normalized to a unity gain
+static const float strict8x[] = {
+    // phase 0
+    -1.21667642e-05f, 7.66466663e-05f, -0.000240807619f, 0.000581057416f, -0.00120285672f, 0.00224660849f,
+    -0.00390229059f, 0.00645084492f, -0.0103849505f, 0.0168000973f, -0.0290258756f, 0.0647267441f, 0.993493824f,
+    -0.0567370192f, 0.0269064758f, -0.0157906652f, 0.00979004581f, -0.00606987121f, 0.00365354801f, -0.00208719104f,
+    0.00110532314f, -0.000525595172f, 0.00021248718f, -6.44127947e-05f,
+    // phase 1
+    -4.7695766e-05f, 0.000257456698f, -0.000774150135f, 0.00182507831f, -0.00372184393f, 0.00687878466f, -0.0118603256f,
+    0.0195154171f, -0.0313726976f, 0.0509482914f, -0.0894671238f, 0.213914311f, 0.942313845f, -0.143499357f,
+    0.0712299715f, -0.0422989386f, 0.0262821924f, -0.0162572102f, 0.00973338786f, -0.0055156261f, 0.00288770556f,
+    -0.00135058268f, 0.000531707942f, -0.000152597152f,
+    // phase 2
+    -9.43573304e-05f, 0.000450992027f, -0.00130320637f, 0.00300596907f, -0.00604289306f, 0.0110567918f, -0.0189302943f,
+    0.0310154228f, -0.0498142917f, 0.0812871178f, -0.145494113f, 0.380225624f, 0.844779506f, -0.192713629f,
+    0.0993383228f, -0.0595845048f, 0.037076551f, -0.0228712427f, 0.0136157719f, -0.00765061736f, 0.00395789991f,
+    -0.00181911002f, 0.000696023862f, -0.000187733308f,
+    // phase 3
+    -0.000142900981f, 0.000618421561f, -0.00172329432f, 0.00389397977f, -0.00772181697f, 0.0139932029f, -0.0237978416f,
+    0.0388378976f, -0.0623540349f, 0.102350531f, -0.18735669f, 0.550431459f, 0.710025598f, -0.205678284f, 0.109416965f,
+    -0.0661875873f, 0.0412181188f, -0.0253459652f, 0.0149985223f, -0.00835336846f, 0.00426782633f, -0.0019258076f,
+    0.000714523483f, -0.000179454303f,
+    // phase 4
+    -0.000179454303f, 0.000714523483f, -0.0019258076f, 0.00426782633f, -0.00835336846f, 0.0149985223f, -0.0253459652f,
+    0.0412181188f, -0.0661875873f, 0.109416965f, -0.205678284f, 0.710025598f, 0.550431459f, -0.18735669f, 0.102350531f,
+    -0.0623540349f, 0.0388378976f, -0.0237978416f, 0.0139932029f, -0.00772181697f, 0.00389397977f, -0.00172329432f,
+    0.000618421561f, -0.000142900981f,
+    // phase 5
+    -0.000187733308f, 0.000696023862f, -0.00181911002f, 0.00395789991f, -0.00765061736f, 0.0136157719f, -0.0228712427f,
+    0.037076551f, -0.0595845048f, 0.0993383228f, -0.192713629f, 0.844779506f, 0.380225624f, -0.145494113f,
+    0.0812871178f, -0.0498142917f, 0.0310154228f, -0.0189302943f, 0.0110567918f, -0.00604289306f, 0.00300596907f,
+    -0.00130320637f, 0.000450992027f, -9.43573304e-05f,
+    // phase 6
+    -0.000152597152f, 0.000531707942f, -0.00135058268f, 0.00288770556f, -0.0055156261f, 0.00973338786f, -0.0162572102f,
+    0.0262821924f, -0.0422989386f, 0.0712299715f, -0.143499357f, 0.942313845f, 0.213914311f, -0.0894671238f,
+    0.0509482914f, -0.0313726976f, 0.0195154171f, -0.0118603256f, 0.00687878466f, -0.00372184393f, 0.00182507831f,
+    -0.000774150135f, 0.000257456698f, -4.7695766e-05f,
+    // phase 7
+    -6.44127947e-05f, 0.00021248718f, -0.000525595172f, 0.00110532314f, -0.00208719104f, 0.00365354801f,
+    -0.00606987121f, 0.00979004581f, -0.0157906652f, 0.0269064758f, -0.0567370192f, 0.993493824f, 0.0647267441f,
+    -0.0290258756f, 0.0168000973f, -0.0103849505f, 0.00645084492f, -0.00390229059f, 0.00224660849f, -0.00120285672f,
+    0.000581057416f, -0.000240807619f, 7.66466663e-05f, -1.21667642e-05f
+};
+
+// Half-band filters (Kaiser window, beta = 4): only the interpolating branch is stored, the other one is a delay
+static const float halfband23[] = {
+    -0.00512628301f, 0.017726647f, -0.0421501564f, 0.0877393774f, -0.186447944f, 0.628258359f, 0.628258359f,
+    -0.186447944f, 0.0877393774f, -0.0421501564f, 0.017726647f, -0.00512628301f
+};
+
+static const float halfband11[] = {
+    0.011330549f, -0.108531688f, 0.597201139f, 0.597201139f, -0.108531688f, 0.011330549f
+};
+
+static const float halfband7[] = {
+    -0.0186169214f, 0.518616921f, 0.518616921f, -0.0186169214f
+};
+
+static const size_t fast2xTaps[] = {12};
+static const float* const fast2xCoefficients[] = {halfband23};
+static const size_t fast4xTaps[] = {12, 6};
+static const float* const fast4xCoefficients[] = {halfband23, halfband11};
+static const size_t fast8xTaps[] = {12, 6, 4};
+static const float* const fast8xCoefficients[] = {halfband23, halfband11, halfband7};
+
+const TruePeakFilterDesign& getTruePeakFilterDesign(const ETruePeakFilter filter)
+{
+    static const TruePeakFilterDesign designs[] = {
+        {0, 0, NULL, 0, NULL, NULL},                     // eTruePeakFilterLegacy: computed by the TruePeakMeter
+        {2, 32, strict2x, 0, NULL, NULL},                // eTruePeakFilterStrict2x
+        {4, 12, strict4x, 0, NULL, NULL},                // eTruePeakFilterStrict4x
+        {8, 24, strict8x, 0, NULL, NULL},                // eTruePeakFilterStrict8x
+        {2, 0, NULL, 1, fast2xTaps, fast2xCoefficients}, // eTruePeakFilterFast2x
+        {4, 0, NULL, 2, fast4xTaps, fast4xCoefficients}, // eTruePeakFilterFast4x
+        {8, 0, NULL, 3, fast8xTaps, fast8xCoefficients}  // eTruePeakFilterFast8x
+    };
+    return designs[filter];
+}
+}
+}
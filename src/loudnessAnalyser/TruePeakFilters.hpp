@@ -0,0 +1,53 @@
+#ifndef _LOUDNESS_ANALYSER_TRUE_PEAK_FILTERS_HPP_
+#define _LOUDNESS_ANALYSER_TRUE_PEAK_FILTERS_HPP_
+
+#include <loudnessCommon/common.hpp>
+
+#include <cstdlib>
+
+namespace Loudness
+{
+namespace analyser
+{
+
+/**
+ * Oversampling filters of the TruePeakMeter.
+ * The accuracy is the maximal deviation of the gain of the filter (over all its phases) for an input at 48kHz, it
+ * scales with the sample rate.
+ * Whatever the filter, the sample grid of the oversampled signal can under-read a sinusoid of frequency f up to
+ * 20*log10( cos( pi * f / ( factor * fs ) ) ): at 20kHz for 48kHz, 2.0dB in 2x, 0.47dB in 4x and 0.12dB in 8x.
+ **/
+enum LoudnessExport ETruePeakFilter
+{
+    eTruePeakFilterLegacy = 0, ///< windowless sinc of 125 taps, factor = upsampling frequency / sample rate (default)
+    eTruePeakFilterStrict2x,   ///< 2 phases of 32 taps: +/-0.001dB up to 20kHz
+    eTruePeakFilterStrict4x,   ///< ITU-R BS.1770-4, 4 phases of 12 taps: +/-0.24dB up to 20kHz
+    eTruePeakFilterStrict8x,   ///< 8 phases of 24 taps: +/-0.001dB up to 18kHz, +/-0.14dB up to 20kHz
+    eTruePeakFilterFast2x,     ///< half-band of 23 taps (12 products per sample): +/-0.08dB up to 18kHz, -1.2dB at 20kHz
+    eTruePeakFilterFast4x,     ///< half-bands of 23 and 11 taps (24 products): +/-0.16dB up to 18kHz, -1.2dB at 20kHz
+    eTruePeakFilterFast8x      ///< half-bands of 23, 11 and 7 taps (40 products): +/-0.24dB up to 18kHz, -1.3dB at 20kHz
+};
+
+/**
+ * Precomputed coefficients of an oversampling filter: either a polyphase filter, or a cascade of 2x half-band filters.
+ **/
+struct TruePeakFilterDesign
+{
+    size_t factor; ///< oversampling factor
+
+    size_t nbTaps;             ///< polyphase: number of taps of each phase
+    const float* coefficients; ///< polyphase: factor phases of nbTaps, applied to x[n], x[n-1]...
+
+    size_t nbStages;                       ///< half-band: number of 2x stages
+    const size_t* stageTaps;               ///< half-band: number of taps of the interpolating branch of each stage
+    const float* const* stageCoefficients; ///< half-band: interpolating branch of each stage (symmetric)
+};
+
+/**
+ * \return the coefficients of the filter (nothing is precomputed for eTruePeakFilterLegacy)
+ **/
+const TruePeakFilterDesign& getTruePeakFilterDesign(const ETruePeakFilter filter);
+}
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include "TruePeakMeter.hpp"
 
 #include <algorithm>
+#include <map>
+#include <mutex>
 #include <emmintrin.h>
 
 namespace Loudness
@@ -17,6 +19,10 @@ TruePeakMeter::TruePeakMeter()
     , _maxSignal(0)
     , _frequencySampling(0)
     , _upsamplingFrequency(192000)
+    , _overshootBound(1.0)
+    , _filter(eTruePeakFilterLegacy)
+    , _windowIndex(0)
+    , _inputHistoryIndex(0)
     , _enableOptimization(true)
 {
 }
@@ -24,69 +30,160 @@ TruePeakMeter::TruePeakMeter()
 void TruePeakMeter::initialize(const int frequencySampling)
 {
     _frequencySampling = frequencySampling;
-    _factor = _upsamplingFrequency / _frequencySampling;
 
-    _coefficients.clear();
-    _historySamples.clear();
-    for(int i = 0; i < 4; i++)
+    if(_filter == eTruePeakFilterLegacy)
+        initializeLegacyFilter();
+    else
+        initializeFilterDesign();
+
+    // detect once if hardware is able to launch SSE2 instructions
+    static const bool hasSimdSSE2 = common::HardwareDetection().hasSimdSSE2();
+    if(!hasSimdSSE2)
     {
-        _orderedCoefficientsScale4[i].clear();
-        _orderedCoefficientsScale8[i].clear();
-        _orderedCoefficientsScale8[2 * i + 1].clear();
+        _enableOptimization = false;
     }
+}
+
+void TruePeakMeter::initializeLegacyFilter()
+{
+    _factor = _upsamplingFrequency / _frequencySampling;
+    _legacyDesign = getLegacyFilterDesign(_frequencySampling, _upsamplingFrequency);
+    _historySamples.assign(_legacyDesign->historySize, 0.0);
+    _overshootBound = _legacyDesign->overshootBound;
+}
+
+std::shared_ptr<const TruePeakMeter::LegacyFilterDesign>
+TruePeakMeter::getLegacyFilterDesign(const double frequencySampling, const double upsamplingFrequency)
+{
+    // the designs are immutable: they are shared by all the meters of the process (all channels, all analysers)
+    static std::mutex mutex;
+    static std::map<std::pair<double, double>, std::shared_ptr<const LegacyFilterDesign> > designs;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const LegacyFilterDesign>& design = designs[std::make_pair(frequencySampling, upsamplingFrequency)];
+    if(!design)
+        design = computeLegacyFilterDesign(upsamplingFrequency / frequencySampling);
+    return design;
+}
+
+std::shared_ptr<const TruePeakMeter::LegacyFilterDesign> TruePeakMeter::computeLegacyFilterDesign(const double factor)
+{
+    std::shared_ptr<LegacyFilterDesign> design = std::make_shared<LegacyFilterDesign>();
+    std::vector<float>& coefficients = design->coefficients;
 
     // process coefficients for i= -FILTER_SIZE/2 to i = FILTER_SIZE/2
     // but impulse response is symetric [ H(-i) = H(i) ]
     for(int i = FILTER_SIZE * 0.5 - 0.5; i > 0; --i)
     {
-        _coefficients.push_back(_factor * std::sin(M_PI * i / _factor) / (M_PI * i));
+        coefficients.push_back(factor * std::sin(M_PI * i / factor) / (M_PI * i));
     }
     // for 0, the sinc is equel to 1
-    _coefficients.push_back(1.0);
+    coefficients.push_back(1.0);
 
     // process positive index
     for(int i = 1.0; i < FILTER_SIZE * 0.5; ++i)
     {
-        _coefficients.push_back(_factor * std::sin(M_PI * i / _factor) / (M_PI * i));
+        coefficients.push_back(factor * std::sin(M_PI * i / factor) / (M_PI * i));
     }
 
-    for(size_t i = 0; i < FILTER_SIZE / _factor; i++)
-        _historySamples.push_back(0.0);
+    // the taps are read with an integer step (see processSample): with a fractional factor (44.1kHz multiples),
+    // more samples than FILTER_SIZE / factor are read
+    size_t nbTaps = 0;
+    for(int iter = 0; iter < FILTER_SIZE; iter += factor)
+        nbTaps++;
+    design->historySize = std::max((double)nbTaps, std::ceil(FILTER_SIZE / factor));
 
     // fill to process easly on SIMD (4 datas on the same time)
     size_t fill = 4 - (int)FILTER_SIZE % 4;
     for(size_t i = 0; i < fill; ++i)
     {
-        _coefficients.push_back(0.0);
-        _historySamples.push_back(0.0);
+        coefficients.push_back(0.0);
     }
+    design->historySize += fill;
 
-    for(size_t i = 0; i < _coefficients.size(); i += 4)
+    for(size_t i = 0; i < coefficients.size(); i += 4)
     {
         for(size_t n = 0; n < 4; n++)
         {
-            _orderedCoefficientsScale4[n].push_back(_coefficients.at(i + n));
+            design->orderedCoefficientsScale4[n].push_back(coefficients.at(i + n));
         }
     }
 
-    for(size_t i = 0; i < _coefficients.size(); i += 8)
+    // worst-case inter-sample overshoot: each phase sums the same coefficients as in processSample
+    design->overshootBound = 1.0;
+    for(int interSampleIdx = 0; interSampleIdx < factor; interSampleIdx++)
     {
-        for(size_t n = 0; n < 8; n++)
+        double gain = 0.0;
+        for(int iter = 0; iter + interSampleIdx < FILTER_SIZE; iter += factor)
+            gain += std::abs(coefficients.at(interSampleIdx + iter));
+        design->overshootBound = std::max(design->overshootBound, gain);
+    }
+    return design;
+}
+
+void TruePeakMeter::initializeFilterDesign()
+{
+    const TruePeakFilterDesign& design = getTruePeakFilterDesign(_filter);
+    _factor = design.factor;
+
+    _phaseCoefficients.clear();
+    _stages.clear();
+    _overshootBound = 1.0;
+    size_t historySize = 0;
+
+    if(design.nbStages == 0)
+    {
+        for(size_t phase = 0; phase < design.factor; phase++)
         {
-            _orderedCoefficientsScale8[n].push_back(_coefficients.at(i + n));
+            // the window is read from the oldest sample: reverse the coefficients
+            const float* coefficients = design.coefficients + phase * design.nbTaps;
+            double gain = 0.0;
+            for(size_t i = 0; i < design.nbTaps; i++)
+            {
+                _phaseCoefficients.push_back(coefficients[design.nbTaps - 1 - i]);
+                gain += std::abs(coefficients[i]);
+            }
+            _overshootBound = std::max(_overshootBound, gain);
         }
+        _window.assign(2 * design.nbTaps, 0.0);
+        _windowIndex = 0;
+        historySize = design.nbTaps;
     }
-
-    // detect if hardware is able to launch SSE2 instructions
-    common::HardwareDetection hardware;
-    if(!hardware.hasSimdSSE2())
+    else
     {
-        _enableOptimization = false;
+        _stages.resize(design.nbStages);
+        for(size_t stage = 0; stage < design.nbStages; stage++)
+        {
+            const size_t nbTaps = design.stageTaps[stage];
+            HalfbandStage& halfband = _stages.at(stage);
+            halfband.coefficients.assign(design.stageCoefficients[stage], design.stageCoefficients[stage] + nbTaps);
+            std::reverse(halfband.coefficients.begin(), halfband.coefficients.end());
+            halfband.window.assign(2 * nbTaps, 0.0);
+            halfband.windowIndex = 0;
+
+            // the output of a stage is the input of the next one: the gains are multiplied
+            double gain = 0.0;
+            for(size_t i = 0; i < nbTaps; i++)
+                gain += std::abs(halfband.coefficients.at(i));
+            _overshootBound *= std::max(1.0, gain);
+            historySize += nbTaps;
+        }
     }
+
+    _inputHistory.assign(historySize, 0.0);
+    _inputHistoryIndex = 0;
 }
 
 float TruePeakMeter::processSample(const double sample)
 {
+    if(_filter != eTruePeakFilterLegacy)
+    {
+        processFilterSample(sample, true);
+        _maxValue = std::max(_maxValue, std::abs(sample));
+        _maxSignal = std::max(_maxSignal, std::abs(sample));
+        return _maxValue;
+    }
+
     _historySamples.erase(_historySamples.begin());
     _historySamples.push_back(sample);
 
@@ -98,8 +195,8 @@ float TruePeakMeter::processSample(const double sample)
         if(_enableOptimization && _factor == 4.0)
         {
             __m128 sum = _mm_set1_ps(0.0);
-            const size_t maxIter = _orderedCoefficientsScale4[interSampleIdx].size();
-            const float* coefsPtr = &_orderedCoefficientsScale4[interSampleIdx][0];
+            const size_t maxIter = _legacyDesign->orderedCoefficientsScale4[interSampleIdx].size();
+            const float* coefsPtr = &_legacyDesign->orderedCoefficientsScale4[interSampleIdx][0];
             const float* histPtr = &_historySamples[0];
             for(size_t iter = 0; iter < maxIter; iter += 4)
             {
@@ -117,7 +214,7 @@ float TruePeakMeter::processSample(const double sample)
             int historySampleIndex = 0;
             for(int iter = 0; iter + interSampleIdx < FILTER_SIZE; iter += _factor, historySampleIndex++)
             {
-                tmpValue += _coefficients.at(interSampleIdx + iter) *
+                tmpValue += _legacyDesign->coefficients.at(interSampleIdx + iter) *
                             _historySamples.at(_historySamples.size() - historySampleIndex - 1);
             }
         }
@@ -130,5 +227,164 @@ float TruePeakMeter::processSample(const double sample)
 
     return _maxValue;
 }
+
+float TruePeakMeter::processBlock(const float* samples, const size_t nbSamples, const float blockPeak,
+                                  const double gateLevel)
+{
+    // margin for the rounding errors of the filter accumulation
+    static const double roundingMargin = 1.0001;
+
+    const std::vector<float>& history = _filter == eTruePeakFilterLegacy ? _historySamples : _inputHistory;
+    const float windowPeak = std::max(blockPeak, computePeak(&history[0], history.size()));
+    if(windowPeak >= SILENCE_LEVEL && windowPeak * _overshootBound * roundingMargin > std::max(gateLevel, _maxValue))
+    {
+        for(size_t i = 0; i < nbSamples; i++)
+            processSample(samples[i]);
+        return _maxValue;
+    }
+
+    // the filter output cannot reach the gate level: keep the last samples for the next blocks
+    const size_t historySize = history.size();
+    if(_filter == eTruePeakFilterLegacy)
+    {
+        if(nbSamples >= historySize)
+        {
+            std::copy(samples + nbSamples - historySize, samples + nbSamples, _historySamples.begin());
+        }
+        else
+        {
+            _historySamples.erase(_historySamples.begin(), _historySamples.begin() + nbSamples);
+            _historySamples.insert(_historySamples.end(), samples, samples + nbSamples);
+        }
+    }
+    else
+    {
+        // the states of the filter depend only on the last historySize samples
+        const size_t start = nbSamples > historySize ? nbSamples - historySize : 0;
+        for(size_t i = start; i < nbSamples; i++)
+            processFilterSample(samples[i], false);
+    }
+    _maxValue = std::max(_maxValue, (double)blockPeak);
+    _maxSignal = std::max(_maxSignal, (double)blockPeak);
+
+    return _maxValue;
+}
+
+void TruePeakMeter::processFilterSample(const float sample, const bool updateMax)
+{
+    _inputHistory[_inputHistoryIndex] = sample;
+    if(++_inputHistoryIndex == _inputHistory.size())
+        _inputHistoryIndex = 0;
+
+    if(!_stages.empty())
+    {
+        processHalfbandStages(sample, updateMax);
+        return;
+    }
+
+    // store the sample twice, to read the window of the filter at once (from the oldest sample)
+    const size_t nbTaps = _window.size() / 2;
+    _window[_windowIndex] = _window[_windowIndex + nbTaps] = sample;
+    if(++_windowIndex == nbTaps)
+        _windowIndex = 0;
+    const float* window = &_window[_windowIndex];
+
+    if(!updateMax)
+        return;
+
+    float peak = 0.0;
+    for(size_t phase = 0; phase < _factor; phase++)
+        peak = std::max(peak, std::abs(filterWindow(&_phaseCoefficients[phase * nbTaps], window, nbTaps)));
+    _maxValue = std::max(_maxValue, (double)peak);
+}
+
+void TruePeakMeter::processHalfbandStages(const float sample, const bool updateMax)
+{
+    // each stage doubles the number of samples
+    float buffers[2][MAX_HALFBAND_OUTPUTS];
+    float* input = buffers[0];
+    float* output = buffers[1];
+    size_t nbSamples = 1;
+    input[0] = sample;
+
+    for(size_t stage = 0; stage < _stages.size(); stage++)
+    {
+        HalfbandStage& halfband = _stages[stage];
+        const size_t nbTaps = halfband.coefficients.size();
+        for(size_t i = 0; i < nbSamples; i++)
+        {
+            halfband.window[halfband.windowIndex] = halfband.window[halfband.windowIndex + nbTaps] = input[i];
+            if(++halfband.windowIndex == nbTaps)
+                halfband.windowIndex = 0;
+            const float* window = &halfband.window[halfband.windowIndex];
+
+            // interpolated sample, then the input delayed to the center of the filter
+            output[2 * i] = filterSymmetricWindow(&halfband.coefficients[0], window, nbTaps);
+            output[2 * i + 1] = window[nbTaps / 2];
+        }
+        nbSamples *= 2;
+        std::swap(input, output);
+    }
+
+    if(updateMax)
+    {
+        float peak = 0.0;
+        for(size_t i = 0; i < nbSamples; i++)
+            peak = std::max(peak, std::abs(input[i]));
+        _maxValue = std::max(_maxValue, (double)peak);
+    }
+}
+
+float TruePeakMeter::filterWindow(const float* coefficients, const float* window, const size_t nbTaps) const
+{
+    double value = 0.0;
+    size_t i = 0;
+
+    // SSE2 instructions (the horizontal sum costs more than a short filter)
+    if(_enableOptimization && nbTaps >= 8)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for(; i + 4 <= nbTaps; i += 4)
+            sum = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(window + i), _mm_loadu_ps(coefficients + i)), sum);
+        float tmp[4];
+        _mm_storeu_ps(tmp, sum);
+        value = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+    }
+    for(; i < nbTaps; i++)
+        value += coefficients[i] * window[i];
+
+    return value;
+}
+
+float TruePeakMeter::filterSymmetricWindow(const float* coefficients, const float* window, const size_t nbTaps) const
+{
+    // symmetric coefficients: add the samples which share a coefficient first
+    float value = 0.0;
+    for(size_t i = 0; i < nbTaps / 2; i++)
+        value += coefficients[i] * (window[i] + window[nbTaps - 1 - i]);
+    return value;
+}
+
+float TruePeakMeter::computePeak(const float* samples, const size_t nbSamples) const
+{
+    float peak = 0.0;
+    size_t i = 0;
+
+    // SSE2 instructions
+    if(_enableOptimization)
+    {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 max = _mm_setzero_ps();
+        for(; i + 4 <= nbSamples; i += 4)
+            max = _mm_max_ps(max, _mm_and_ps(_mm_loadu_ps(samples + i), absMask));
+        float tmp[4];
+        _mm_storeu_ps(tmp, max);
+        peak = std::max(std::max(tmp[0], tmp[1]), std::max(tmp[2], tmp[3]));
+    }
+    for(; i < nbSamples; i++)
+        peak = std::max(peak, std::abs(samples[i]));
+
+    return peak;
+}
 }
 }
@@ -2,8 +2,10 @@
 #define _LOUDNESS_ANALYSER_TRUE_PEAK_METER_HPP_
 
 #include <loudnessCommon/common.hpp>
+#include "TruePeakFilters.hpp"
 
 #include <cstdlib>
+#include <memory>
 #include <vector>
 
 namespace Loudness
@@ -25,12 +27,26 @@ public:
         _maxValue = 0;
         _frequencySampling = 0;
         _upsamplingFrequency = 192000.0;
+        _filter = eTruePeakFilterLegacy;
     }
 
     void resetMaxValue() { _maxValue = 0; }
 
     float processSample(const double sample);
 
+    /**
+     * Process a block of samples, but run the oversampling filter only if it can raise the true peak above gateLevel.
+     * The filter output is bounded by the sample peak of its window times the gain of its worst phase
+     * (see _overshootBound): if this bound stays under gateLevel, only the history and the sample peak are updated.
+     * With gateLevel set to the running true peak of the program, the maximum over the program stays exact.
+     * A silent window (under SILENCE_LEVEL) is always skipped.
+     * \param blockPeak sample peak of the block (see computePeak)
+     * \return the max value of the current period (as processSample)
+     */
+    float processBlock(const float* samples, const size_t nbSamples, const float blockPeak, const double gateLevel);
+
+    float computePeak(const float* samples, const size_t nbSamples) const;
+
     float getTruePeakValue()
     {
         // std::cout << "max signal = " <<  _maxSignal << " = " << 20.0 * std::log10( _maxSignal )  << "dB\t max true peak "
@@ -40,21 +56,71 @@ public:
 
     void setUpsamplingFrequencyInHz(const size_t frequency) { _upsamplingFrequency = frequency; }
 
+    /**
+     * Select the oversampling filter, set at the next initialize.
+     * The upsampling frequency is used only by eTruePeakFilterLegacy.
+     */
+    void setFilter(const ETruePeakFilter filter) { _filter = filter; }
+
+private:
+    struct HalfbandStage
+    {
+        std::vector<float> coefficients; ///< interpolating branch, in the order of the window
+        std::vector<float> window;       ///< last input samples of the stage, stored twice
+        size_t windowIndex;
+    };
+
+    /**
+     * Coefficients of the legacy filter, which depend only on the upsampling factor.
+     */
+    struct LegacyFilterDesign
+    {
+        std::vector<float> coefficients;
+        std::vector<float> orderedCoefficientsScale4[4]; ///< phases of the SSE2 4x filter
+        size_t historySize;
+        double overshootBound;
+    };
+
+    void initializeLegacyFilter();
+    /**
+     * Get the design of the legacy filter, computed at its first use by the process.
+     */
+    static std::shared_ptr<const LegacyFilterDesign> getLegacyFilterDesign(const double frequencySampling,
+                                                                           const double upsamplingFrequency);
+    static std::shared_ptr<const LegacyFilterDesign> computeLegacyFilterDesign(const double factor);
+    void initializeFilterDesign();
+
+    /**
+     * Oversample a sample with the selected filter design.
+     * \param updateMax false to only update the states of the filter
+     */
+    void processFilterSample(const float sample, const bool updateMax);
+    void processHalfbandStages(const float sample, const bool updateMax);
+    float filterWindow(const float* coefficients, const float* window, const size_t nbTaps) const;
+    float filterSymmetricWindow(const float* coefficients, const float* window, const size_t nbTaps) const;
+
 private:
     static const int FILTER_SIZE = 125;
+    static const size_t MAX_HALFBAND_OUTPUTS = 8; ///< for a 8x oversampling
 
 private:
     std::vector<float> _historySamples;
-    std::vector<float> _coefficients;
-
-    std::vector<float> _orderedCoefficientsScale4[4];
-    std::vector<float> _orderedCoefficientsScale8[8];
+    std::shared_ptr<const LegacyFilterDesign> _legacyDesign; /// shared by the meters with the same factor
 
     double _maxValue;            /// maximum value of the upsampled signal
     double _maxSignal;           /// maximum value of the signal
     double _frequencySampling;   /// input frequency sampling
     double _upsamplingFrequency; /// output frequency sampling
     double _factor;              /// upsampling scale factor
+    double _overshootBound;      /// max gain of the filter: sum of absolute coefficients of the worst phase
+
+    ETruePeakFilter _filter;               /// oversampling filter
+    std::vector<float> _phaseCoefficients; /// polyphase design: phases in the order of the window
+    std::vector<float> _window;            /// polyphase design: last input samples, stored twice
+    size_t _windowIndex;                   /// polyphase design: position of the oldest sample in _window
+    std::vector<HalfbandStage> _stages;    /// half-band design: cascade of 2x stages
+    std::vector<float> _inputHistory;      /// filter design: input samples which the next outputs depend on
+    size_t _inputHistoryIndex;             /// filter design: next position in _inputHistory
 
     bool _enableOptimization;
 };
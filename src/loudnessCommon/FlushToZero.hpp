@@ -0,0 +1,40 @@
+#ifndef _LOUDNESS_COMMON_FLUSH_TO_ZERO_HPP_
+#define _LOUDNESS_COMMON_FLUSH_TO_ZERO_HPP_
+
+#include <xmmintrin.h>
+
+namespace Loudness
+{
+namespace common
+{
+
+/**
+ * Flush denormal results to zero (FTZ) and read denormal inputs as zero (DAZ) in the current thread, while in scope.
+ * The filters decay to denormal values on silence, and denormal arithmetic is very slow on x86 processors.
+ * The previous mode is restored when leaving the scope, so the floating point behaviour of the caller is unchanged.
+ **/
+class ScopedFlushToZero
+{
+public:
+    ScopedFlushToZero()
+        : _previousMode(_mm_getcsr())
+    {
+        _mm_setcsr(_previousMode | flushToZeroFlag | denormalsAreZeroFlag);
+    }
+
+    ~ScopedFlushToZero() { _mm_setcsr(_previousMode); }
+
+private:
+    ScopedFlushToZero(const ScopedFlushToZero&);
+    ScopedFlushToZero& operator=(const ScopedFlushToZero&);
+
+private:
+    static const unsigned int flushToZeroFlag = 0x8000;
+    static const unsigned int denormalsAreZeroFlag = 0x0040;
+
+    const unsigned int _previousMode; ///< MXCSR register of the caller
+};
+}
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef _LOUDNESS_COMMON_INSTRUMENTATION_HPP_
+#define _LOUDNESS_COMMON_INSTRUMENTATION_HPP_
+
+#include "Trace.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+namespace Loudness
+{
+namespace common
+{
+
+/**
+ * Counters of a stage of the processing: number of calls, items processed (samples, frames or bytes) and time spent.
+ * The stages are timed per block, never per sample.
+ * Build with LOUDNESS_DISABLE_INSTRUMENTATION to remove the timers: all counters then stay at 0.
+ **/
+struct StageStats
+{
+    StageStats()
+        : calls(0)
+        , items(0)
+        , nanoseconds(0)
+    {
+    }
+
+    StageStats& operator+=(const StageStats& other)
+    {
+        calls += other.calls;
+        items += other.items;
+        nanoseconds += other.nanoseconds;
+        return *this;
+    }
+
+    double getSeconds() const { return nanoseconds * 1e-9; }
+
+    unsigned long long calls;
+    unsigned long long items;
+    unsigned long long nanoseconds;
+};
+
+/**
+ * Add the time spent in its scope to a stage.
+ * If a trace name is given, the span is also recorded in the trace (see TraceSession).
+ **/
+class ScopedStageTimer
+{
+public:
+#ifndef LOUDNESS_DISABLE_INSTRUMENTATION
+    ScopedStageTimer(StageStats& stats, const size_t items = 0, const char* traceName = NULL)
+        : _stats(stats)
+        , _items(items)
+        , _traceName(traceName)
+        , _start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedStageTimer()
+    {
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        _stats.calls++;
+        _stats.items += _items;
+        _stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - _start).count();
+        if(_traceName && TraceSink::getInstance().isEnabled())
+            TraceSink::getInstance().addEvent(_traceName, _start, end);
+    }
+
+    // when the number of items is known at the end of the stage
+    void setItems(const size_t items) { _items = items; }
+
+private:
+    StageStats& _stats;
+    size_t _items;
+    const char* _traceName;
+    const std::chrono::steady_clock::time_point _start;
+#else
+    ScopedStageTimer(StageStats&, const size_t = 0, const char* = NULL) {}
+    void setItems(const size_t) {}
+#endif
+
+private:
+    ScopedStageTimer(const ScopedStageTimer&);
+    ScopedStageTimer& operator=(const ScopedStageTimer&);
+};
+
+/**
+ * Print a line of the counters of a stage.
+ **/
+inline void printStageStats(std::ostream& os, const std::string& name, const StageStats& stats)
+{
+    os << "  " << std::left << std::setw(20) << name << std::right << std::setw(12) << std::fixed
+       << std::setprecision(6) << stats.getSeconds() << " s" << std::setw(12) << stats.calls << " calls"
+       << std::setw(16) << stats.items << " items" << std::endl;
+    os.unsetf(std::ios_base::floatfield);
+}
+}
+}
+
+#endif
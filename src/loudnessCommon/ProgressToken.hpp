@@ -0,0 +1,97 @@
+#ifndef _LOUDNESS_COMMON_PROGRESS_TOKEN_HPP_
+#define _LOUDNESS_COMMON_PROGRESS_TOKEN_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+namespace Loudness
+{
+namespace common
+{
+
+/**
+ * Thrown by a processing which stops because its ProgressToken is cancelled.
+ **/
+class ProcessCancelled : public std::runtime_error
+{
+public:
+    ProcessCancelled()
+        : std::runtime_error("The processing has been cancelled.")
+    {
+    }
+};
+
+/**
+ * Progress and cancellation shared by a processing loop and the thread which controls it.
+ * The loop reports its progress at each block: the callback is called when the value changes, at most once per interval.
+ * The controlling thread calls cancel(): the loop stops at its next block.
+ **/
+class ProgressToken
+{
+public:
+    /**
+     * \param progress percentage of the processing, or seconds processed when the duration is unknown (stream)
+     */
+    typedef std::function<void(const int progress)> ProgressCallback;
+
+    /**
+     * \param callback called by the processing thread, can be empty
+     * \param intervalInSeconds minimal time between two calls of the callback (except for the end at 100)
+     */
+    explicit ProgressToken(const ProgressCallback& callback = ProgressCallback(), const double intervalInSeconds = 0.5)
+        : _callback(callback)
+        , _interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(intervalInSeconds)))
+        , _lastReport()
+        , _lastProgress(-1)
+        , _cancelled(false)
+    {
+    }
+
+    /**
+     * Request the processing to stop, it can be called by any thread.
+     */
+    void cancel() { _cancelled = true; }
+    bool isCancelled() const { return _cancelled; }
+
+    /**
+     * Report the progress of the processing.
+     */
+    void setProgress(const int progress)
+    {
+        if(!_callback || progress == _lastProgress)
+            return;
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(_lastProgress >= 0 && progress < 100 && now - _lastReport < _interval)
+            return;
+        _lastReport = now;
+        _lastProgress = progress;
+        _callback(progress);
+    }
+
+    /**
+     * Throw ProcessCancelled if the processing has been cancelled.
+     */
+    void checkCancellation() const
+    {
+        if(_cancelled)
+            throw ProcessCancelled();
+    }
+
+private:
+    ProgressToken(const ProgressToken&);
+    ProgressToken& operator=(const ProgressToken&);
+
+private:
+    ProgressCallback _callback;
+    const std::chrono::steady_clock::duration _interval;
+    std::chrono::steady_clock::time_point _lastReport;
+    int _lastProgress;
+    std::atomic<bool> _cancelled;
+};
+}
+}
+
+#endif
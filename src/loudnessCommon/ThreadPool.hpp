@@ -0,0 +1,134 @@
+#ifndef _LOUDNESS_COMMON_THREAD_POOL_HPP_
+#define _LOUDNESS_COMMON_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Loudness
+{
+namespace common
+{
+
+/**
+ * Fixed number of threads running the submitted tasks, in their order of submission.
+ * Without thread, the tasks are run by the thread which submits them.
+ **/
+class ThreadPool
+{
+public:
+    /**
+     * \param nbThreads number of threads of the pool, 0 to run the tasks in the calling thread
+     */
+    explicit ThreadPool(const size_t nbThreads)
+        : _nbPendingTasks(0)
+        , _stopped(false)
+    {
+        for(size_t i = 0; i < nbThreads; i++)
+            _threads.push_back(std::thread(&ThreadPool::run, this));
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _taskAvailable.notify_all();
+        for(size_t i = 0; i < _threads.size(); i++)
+            _threads.at(i).join();
+    }
+
+    size_t getNbThreads() const { return _threads.size(); }
+
+    void submit(const std::function<void()>& task)
+    {
+        if(_threads.empty())
+        {
+            execute(task);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(task);
+            _nbPendingTasks++;
+        }
+        _taskAvailable.notify_one();
+    }
+
+    /**
+     * Wait for the end of all the submitted tasks.
+     * The first exception thrown by a task since the last call is thrown again here.
+     */
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _tasksDone.wait(lock, [this] { return _nbPendingTasks == 0; });
+        if(_exception)
+        {
+            std::exception_ptr exception = _exception;
+            _exception = std::exception_ptr();
+            std::rethrow_exception(exception);
+        }
+    }
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void run()
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _taskAvailable.wait(lock, [this] { return _stopped || !_tasks.empty(); });
+                if(_tasks.empty())
+                    return;
+                task = _tasks.front();
+                _tasks.pop_front();
+            }
+            execute(task);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _nbPendingTasks--;
+            }
+            _tasksDone.notify_all();
+        }
+    }
+
+    void execute(const std::function<void()>& task)
+    {
+        try
+        {
+            task();
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(!_exception)
+                _exception = std::current_exception();
+        }
+    }
+
+private:
+    std::vector<std::thread> _threads;
+    std::deque<std::function<void()> > _tasks;
+    size_t _nbPendingTasks; ///< submitted tasks which are not finished
+    bool _stopped;
+    std::exception_ptr _exception; ///< first exception thrown by a task
+
+    std::mutex _mutex;
+    std::condition_variable _taskAvailable;
+    std::condition_variable _tasksDone;
+};
+}
+}
+
+#endif
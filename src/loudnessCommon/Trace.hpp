@@ -0,0 +1,234 @@
+#ifndef _LOUDNESS_COMMON_TRACE_HPP_
+#define _LOUDNESS_COMMON_TRACE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Loudness
+{
+namespace common
+{
+
+/**
+ * Span of the timeline of a thread.
+ * The name must be a string literal: only its pointer is recorded.
+ **/
+struct TraceEvent
+{
+    const char* name;
+    long long start; ///< in nanoseconds since the start of the trace
+    long long duration;
+};
+
+/**
+ * Events recorded by a thread: only this thread appends to it, without lock.
+ **/
+struct TraceBuffer
+{
+    static const size_t MAX_EVENTS = 1 << 22; // about 100MB per thread, the next events are dropped
+
+    TraceBuffer(const size_t threadId)
+        : threadId(threadId)
+        , droppedEvents(0)
+    {
+    }
+
+    const size_t threadId;
+    std::vector<TraceEvent> events;
+    size_t droppedEvents;
+};
+
+/**
+ * Timeline of the processing, exported to the Chrome trace event format (open it in chrome://tracing or Perfetto).
+ * The spans are recorded when a trace is started, see TraceSession.
+ **/
+class TraceSink
+{
+public:
+    static TraceSink& getInstance()
+    {
+        static TraceSink sink;
+        return sink;
+    }
+
+    ~TraceSink()
+    {
+        for(size_t i = 0; i < _buffers.size(); i++)
+            delete _buffers.at(i);
+    }
+
+    bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    void start()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for(size_t i = 0; i < _buffers.size(); i++)
+        {
+            _buffers.at(i)->events.clear();
+            _buffers.at(i)->droppedEvents = 0;
+        }
+        _origin = std::chrono::steady_clock::now();
+        _enabled.store(true);
+    }
+
+    void stop() { _enabled.store(false); }
+
+    void addEvent(const char* name, const std::chrono::steady_clock::time_point& start,
+                  const std::chrono::steady_clock::time_point& end)
+    {
+        TraceBuffer& buffer = getThreadBuffer();
+        if(buffer.events.size() >= TraceBuffer::MAX_EVENTS)
+        {
+            buffer.droppedEvents++;
+            return;
+        }
+        const TraceEvent event = {name, std::chrono::duration_cast<std::chrono::nanoseconds>(start - _origin).count(),
+                                  std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()};
+        buffer.events.push_back(event);
+    }
+
+    /**
+     * Write the events of all threads, when the threads which record them are stopped.
+     * \return false if the file cannot be written
+     */
+    bool write(const std::string& filename)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::ofstream file(filename.c_str());
+        if(!file)
+            return false;
+
+        size_t droppedEvents = 0;
+        char time[64];
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for(size_t i = 0; i < _buffers.size(); i++)
+        {
+            const TraceBuffer& buffer = *_buffers.at(i);
+            file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.threadId
+                 << ",\"args\":{\"name\":\"thread " << buffer.threadId << "\"}}";
+            first = false;
+            for(size_t e = 0; e < buffer.events.size(); e++)
+            {
+                const TraceEvent& event = buffer.events.at(e);
+                // timestamps in microseconds
+                snprintf(time, sizeof(time), "\"ts\":%lld.%03lld,\"dur\":%lld.%03lld", event.start / 1000,
+                         event.start % 1000, event.duration / 1000, event.duration % 1000);
+                file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"loudness\",\"ph\":\"X\"," << time
+                     << ",\"pid\":1,\"tid\":" << buffer.threadId << "}";
+            }
+            droppedEvents += buffer.droppedEvents;
+        }
+        file << "\n]}\n";
+
+        if(droppedEvents)
+            std::cerr << "Warning: " << droppedEvents << " events dropped from the trace " << filename << std::endl;
+        return file.good();
+    }
+
+private:
+    TraceSink()
+        : _enabled(false)
+        , _origin(std::chrono::steady_clock::now())
+    {
+    }
+
+    TraceSink(const TraceSink&);
+    TraceSink& operator=(const TraceSink&);
+
+    TraceBuffer& getThreadBuffer()
+    {
+        static thread_local TraceBuffer* threadBuffer = NULL;
+        if(!threadBuffer)
+        {
+            // first event of the thread
+            std::lock_guard<std::mutex> lock(_mutex);
+            threadBuffer = new TraceBuffer(_buffers.size() + 1);
+            _buffers.push_back(threadBuffer);
+        }
+        return *threadBuffer;
+    }
+
+private:
+    std::atomic<bool> _enabled;
+    std::chrono::steady_clock::time_point _origin;
+    std::mutex _mutex; ///< protects the list of buffers, not their events
+    std::vector<TraceBuffer*> _buffers;
+};
+
+/**
+ * Record the timeline of the processing from its construction to its destruction.
+ * The trace is written to the given file, or to the file of the LOUDNESS_TRACE environment variable.
+ * Without file, nothing is recorded.
+ **/
+class TraceSession
+{
+public:
+    TraceSession(const std::string& filename)
+        : _filename(filename)
+    {
+        if(_filename.empty() && std::getenv("LOUDNESS_TRACE"))
+            _filename = std::getenv("LOUDNESS_TRACE");
+        if(!_filename.empty())
+            TraceSink::getInstance().start();
+    }
+
+    ~TraceSession()
+    {
+        if(_filename.empty())
+            return;
+        TraceSink::getInstance().stop();
+        if(!TraceSink::getInstance().write(_filename))
+            std::cerr << "Error: cannot write the trace " << _filename << std::endl;
+    }
+
+private:
+    TraceSession(const TraceSession&);
+    TraceSession& operator=(const TraceSession&);
+
+    std::string _filename;
+};
+
+/**
+ * Record the span of its scope in the trace (when the trace is enabled).
+ * Use ScopedStageTimer for the stages which are also counted in the stats.
+ **/
+class ScopedTrace
+{
+public:
+#ifndef LOUDNESS_DISABLE_INSTRUMENTATION
+    explicit ScopedTrace(const char* name)
+        : _name(TraceSink::getInstance().isEnabled() ? name : NULL)
+    {
+        if(_name)
+            _start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTrace()
+    {
+        if(_name)
+            TraceSink::getInstance().addEvent(_name, _start, std::chrono::steady_clock::now());
+    }
+
+private:
+    const char* _name;
+    std::chrono::steady_clock::time_point _start;
+#else
+    explicit ScopedTrace(const char*) {}
+#endif
+
+private:
+    ScopedTrace(const ScopedTrace&);
+    ScopedTrace& operator=(const ScopedTrace&);
+};
+}
+}
+
+#endif
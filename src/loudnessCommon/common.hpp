@@ -3,6 +3,7 @@
 
 #define MAX_CHANNELS 5
 #define FRAGMENT_SIZE 64
+#define SILENCE_LEVEL 1e-20f // samples and filter states under this level are processed as a digital silence
 
 #include "system.hpp"
 
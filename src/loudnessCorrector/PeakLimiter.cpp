@@ -63,7 +63,10 @@ int PeakLimiter::apply(const float* samplesIn, float* samplesOut, const size_t&
 
 int PeakLimiter::applyPlanar(const float** samplesIn, float** samplesOut, const size_t& nSamples) {
     const size_t bufferSize = nSamples * _nbChannels;
-    float* interlacedSamplesOut = new float[bufferSize];
+    if (_interlacedBuffer.size() < bufferSize) {
+        _interlacedBuffer.resize(bufferSize);
+    }
+    float* interlacedSamplesOut = &_interlacedBuffer[0];
 
     size_t count = 0;
     for (size_t i = 0; i < nSamples; i++) {
@@ -145,6 +145,9 @@ private:
     std::vector<size_t> _sectionMaxIndexList;
     size_t _sectionIndex; // position of section in max. buffer (in samples)
 
+    // Interlaced copy of the planar buffers, kept between the blocks
+    std::vector<float> _interlacedBuffer;
+
     size_t _outputSamplesCounter;
 };
 
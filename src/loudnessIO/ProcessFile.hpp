@@ -2,6 +2,8 @@
 #define _LOUDNESS_TOOLS_PROCESS_FILE_HPP_
 
 #include <loudnessCommon/common.hpp>
+#include <loudnessCommon/Instrumentation.hpp>
+#include <loudnessCommon/ProgressToken.hpp>
 
 #include <loudnessAnalyser/LoudnessAnalyser.hpp>
 
@@ -15,6 +17,23 @@ namespace Loudness
 namespace io
 {
 
+// Time spent in the I/O and in the correction of the functors (the items are frames)
+struct ProcessorStats
+{
+    common::StageStats read;         ///< read and conversion of the input file
+    common::StageStats deinterleave; ///< deinterleave of the samples to analyse
+    common::StageStats correction;   ///< gain and limiters of the correction
+    common::StageStats write;        ///< conversion and write of the output file
+
+    void print(std::ostream& os) const
+    {
+        common::printStageStats(os, "read", read);
+        common::printStageStats(os, "deinterleave", deinterleave);
+        common::printStageStats(os, "correction", correction);
+        common::printStageStats(os, "write", write);
+    }
+};
+
 // Based class for functor which process audio file and fill LoudnessAnalyser
 class LoudnessExport Processor
 {
@@ -23,6 +42,9 @@ public:
         : _inputAudioFile(audioFile)
         , _cumulOfSamples(0)
         , _totalNbSamples(_inputAudioFile.getNbSamples())
+        , _firstSample(0)
+        , _lastSample(_inputAudioFile.getNbSamples())
+        , _position(0)
         , _channelsInBuffer(std::min(5, _inputAudioFile.getNbChannels())) // skip last channel if 5.1 (LRE channel)
         , _bufferSize(_inputAudioFile.getSampleRate() / 5)
         , _enableOptimization(true)
@@ -42,23 +64,52 @@ public:
         delete[] _inpb;
         for(size_t i = 0; i < _channelsInBuffer; i++)
             delete[] _data[i];
+        delete[] _data;
     }
 
     void init()
     {
-        // Init structures of analysis and seek at the beginning of the file
+        // Init structures of analysis and seek at the beginning of the range
+        // A stream (stdin, pipe) cannot be rewound: it can be processed only once
         _analyser.initAndStart(_channelsInBuffer, _inputAudioFile.getSampleRate(), _enableOptimization);
-        _inputAudioFile.seek(0);
+        // no allocation in the processing loop
+        _analyser.reserve(_totalNbSamples);
+        _position = 0;
+        if(_inputAudioFile.isSeekable() && _inputAudioFile.seek(_firstSample) == SoundFile::eErrorNone)
+            _position = _firstSample;
+    }
+
+    /**
+     * Process only the samples of the range: the file is sought to the first sample, and read up to the last one.
+     * The samples of a stream before the range are read and dropped.
+     * \param firstSample first sample (per channel) of the range
+     * \param lastSample sample after the end of the range, 0 for the end of the file
+     */
+    void setRange(const size_t firstSample, const size_t lastSample = 0)
+    {
+        const size_t nbSamples = _inputAudioFile.getNbSamples();
+        _lastSample = lastSample;
+        if(nbSamples && (lastSample == 0 || lastSample > nbSamples))
+            _lastSample = nbSamples;
+        _firstSample = _lastSample ? std::min(firstSample, _lastSample) : firstSample;
+        _totalNbSamples = _lastSample ? _lastSample - _firstSample : 0;
+        init();
     }
 
+    // False when reading a stream: the progression is then reported in seconds processed instead of percent
+    bool hasKnownDuration() const { return _totalNbSamples != 0; }
+
     // Analyse the nbSamples in _data, and fill LoudnessAnalyser
     void processSamples(const size_t nbSamples)
     {
-        float* p = _inpb;
-        for(size_t i = 0; i < nbSamples; i++)
         {
-            for(size_t c = 0; c < _channelsInBuffer; c++)
-                _data[c][i] = (*p++);
+            common::ScopedStageTimer timer(_stats.deinterleave, nbSamples, "deinterleave");
+            float* p = _inpb;
+            for(size_t i = 0; i < nbSamples; i++)
+            {
+                for(size_t c = 0; c < _channelsInBuffer; c++)
+                    _data[c][i] = (*p++);
+            }
         }
         _analyser.processSamples(_data, nbSamples);
     }
@@ -69,18 +120,70 @@ public:
         init();
     }
 
+    const ProcessorStats& getStats() const { return _stats; }
+
+    // Print the time spent in the I/O and in the correction on standard output
+    void printStats() const
+    {
+        std::cout << "I/O stats:" << std::endl;
+        _stats.print(std::cout);
+        std::cout << std::endl;
+    }
+
 protected:
+    // read a buffer of the input file, up to the end of the range
+    size_t readSamples()
+    {
+        common::ScopedStageTimer timer(_stats.read, 0, "read");
+        while(_position < _firstSample)
+        {
+            const size_t nbSamplesDropped = _inputAudioFile.read(_inpb, std::min(_bufferSize, _firstSample - _position));
+            if(nbSamplesDropped == 0)
+                return 0;
+            _position += nbSamplesDropped;
+        }
+        size_t nbSamplesToRead = _bufferSize;
+        if(_lastSample)
+            nbSamplesToRead = std::min(nbSamplesToRead, _lastSample - std::min(_position, _lastSample));
+        if(nbSamplesToRead == 0)
+            return 0;
+        const size_t nbSamples = _inputAudioFile.read(_inpb, nbSamplesToRead);
+        _position += nbSamples;
+        timer.setItems(nbSamples);
+        return nbSamples;
+    }
+
+    // write nbSamples of the buffer to the output file
+    size_t writeSamples(SoundFile& outputAudioFile, const size_t nbSamples)
+    {
+        common::ScopedStageTimer timer(_stats.write, nbSamples, "write");
+        return outputAudioFile.write(_inpb, nbSamples);
+    }
+
     SoundFile& _inputAudioFile;
 
     size_t _cumulOfSamples;
-    const size_t _totalNbSamples;
+    size_t _totalNbSamples; // of the range
+    size_t _firstSample;    // range to process
+    size_t _lastSample;     // excluded, 0 if the end of a stream is unknown
+    size_t _position;       // of the next sample read in the input file
     const size_t _channelsInBuffer;
     const size_t _bufferSize;
 
     bool _enableOptimization; // if true, use SIMD instructions
 
+    void notifyProgress(common::ProgressToken& token) const
+    {
+        if(hasKnownDuration())
+            token.setProgress((float)_cumulOfSamples / _totalNbSamples * 100);
+        else
+            token.setProgress(_cumulOfSamples / _inputAudioFile.getSampleRate());
+    }
+
     float* _inpb; // input pointer buffer
 
+    ProcessorStats _stats;
+
 private:
     Loudness::analyser::LoudnessAnalyser& _analyser;
     float** _data; // data to analyse loudness
@@ -95,12 +198,20 @@ public:
     {
     }
 
+    // Process the whole file, the callback is called at each change of the progression
     void operator()(void (*callback)(int))
+    {
+        common::ProgressToken token(callback, 0);
+        (*this)(token);
+    }
+
+    // Process the file up to its end or up to the cancellation of the token
+    void operator()(common::ProgressToken& token)
     {
         // While we read samples
-        while(true)
+        while(!token.isCancelled())
         {
-            const size_t nbSamples = _inputAudioFile.read(_inpb, _bufferSize);
+            const size_t nbSamples = readSamples();
             if(nbSamples == 0)
                 break;
 
@@ -109,7 +220,7 @@ public:
 
             // Callback for progression
             _cumulOfSamples += nbSamples;
-            callback((float)_cumulOfSamples / _totalNbSamples * 100);
+            notifyProgress(token);
         }
     }
 };
@@ -126,27 +237,38 @@ public:
     {
     }
 
+    // Process the whole file, the callback is called at each change of the progression
     void operator()(void (*callback)(int))
     {
-        while(true)
+        common::ProgressToken token(callback, 0);
+        (*this)(token);
+    }
+
+    // Process the file up to its end or up to the cancellation of the token
+    void operator()(common::ProgressToken& token)
+    {
+        while(!token.isCancelled())
         {
-            const size_t nbSamples = _inputAudioFile.read(_inpb, _bufferSize);
+            const size_t nbSamples = readSamples();
             if(nbSamples == 0)
                 break;
 
             // Correct input
-            float* p = _inpb;
-            corrector::correctBuffer(p, nbSamples, _channelsInBuffer, _gain);
+            {
+                common::ScopedStageTimer timer(_stats.correction, nbSamples, "correction");
+                float* p = _inpb;
+                corrector::correctBuffer(p, nbSamples, _channelsInBuffer, _gain);
+            }
 
             // Analyse output
             processSamples(nbSamples);
 
             // Write output
-            const size_t nbSamplesWritten = _outputAudioFile.write(_inpb, nbSamples);
+            const size_t nbSamplesWritten = writeSamples(_outputAudioFile, nbSamples);
 
             // Callback for progression
             _cumulOfSamples += nbSamplesWritten;
-            callback((float)_cumulOfSamples / _totalNbSamples * 100);
+            notifyProgress(token);
         }
     }
 
@@ -183,34 +305,50 @@ public:
         }
     }
 
+    // Process the whole file, the callback is called at each change of the progression
     void operator()(void (*callback)(int))
     {
-        while(true)
+        common::ProgressToken token(callback, 0);
+        (*this)(token);
+    }
+
+    // Process the file up to its end or up to the cancellation of the token
+    void operator()(common::ProgressToken& token)
+    {
+        while(!token.isCancelled())
         {
-            const size_t nbSamples = _inputAudioFile.read(_inpb, _bufferSize);
+            const size_t nbSamples = readSamples();
             if(nbSamples == 0)
                 break;
 
             // Correct input
-            float* ptr = _inpb;
-            size_t nbSamplesCorrected = corrector::correctBuffer(_limiters, ptr, nbSamples, _channelsInBuffer, _gain);
+            size_t nbSamplesCorrected = 0;
+            {
+                common::ScopedStageTimer timer(_stats.correction, nbSamples, "correction");
+                float* ptr = _inpb;
+                nbSamplesCorrected = corrector::correctBuffer(_limiters, ptr, nbSamples, _channelsInBuffer, _gain);
+            }
 
             // Analyse output
             processSamples(nbSamples);
 
             // Write output
-            const size_t nbSamplesWritten = _outputAudioFile.write(_inpb, nbSamplesCorrected);
+            const size_t nbSamplesWritten = writeSamples(_outputAudioFile, nbSamplesCorrected);
 
             // Callback for progression
             _cumulOfSamples += nbSamplesWritten;
-            callback((float)_cumulOfSamples / _totalNbSamples * 100);
+            notifyProgress(token);
         }
 
-        while(true)
+        while(!token.isCancelled())
         {
-            float* ptr = _inpb;
-
-            const size_t lastSamples = getLastData(_limiters, ptr, _bufferSize, _channelsInBuffer, _gain);
+            size_t lastSamples = 0;
+            {
+                common::ScopedStageTimer timer(_stats.correction, 0, "correction");
+                float* ptr = _inpb;
+                lastSamples = getLastData(_limiters, ptr, _bufferSize, _channelsInBuffer, _gain);
+                timer.setItems(lastSamples);
+            }
             if(lastSamples == 0)
                 break;
 
@@ -218,11 +356,11 @@ public:
             processSamples(lastSamples);
 
             // Write output
-            const size_t lastSamplesWritten = _outputAudioFile.write(_inpb, lastSamples);
+            const size_t lastSamplesWritten = writeSamples(_outputAudioFile, lastSamples);
 
             // Callback for progression
             _cumulOfSamples += lastSamplesWritten;
-            callback((float)_cumulOfSamples / _totalNbSamples * 100);
+            notifyProgress(token);
         }
     }
 
@@ -46,16 +46,55 @@ void SoundFile::reset(void)
     _sampleRate = 0;
     _nbChannels = 0;
     _nbSamples = 0;
+    _seekable = false;
 }
 
 int SoundFile::open_read(const char* name)
 {
     SF_INFO I;
+    memset(&I, 0, sizeof(I));
+    return open_read(name, I);
+}
+
+int SoundFile::open_read_raw(const char* name, int sampleRate, int nbChannels, int bitDepth)
+{
+    SF_INFO I;
+    memset(&I, 0, sizeof(I));
+
+    if(!sampleRate || !nbChannels)
+        return eErrorOpen;
+
+    I.format = SF_FORMAT_RAW | SF_ENDIAN_LITTLE;
+    switch(bitDepth)
+    {
+        case eBitDepth16Bits:
+            I.format |= SF_FORMAT_PCM_16;
+            break;
+        case eBitDepth24Bits:
+            I.format |= SF_FORMAT_PCM_24;
+            break;
+        case eBitDepth32Bits:
+            I.format |= SF_FORMAT_PCM_32;
+            break;
+        case eBitDepthFloat:
+            I.format |= SF_FORMAT_FLOAT;
+            break;
+        default:
+            return eErrorBitDepth;
+    }
+    I.samplerate = sampleRate;
+    I.channels = nbChannels;
 
+    return open_read(name, I);
+}
+
+int SoundFile::open_read(const char* name, SF_INFO& I)
+{
     if(_readWriteMode)
         return eErrorRwMode;
     reset();
 
+    // libsndfile reads the standard input when the name is "-"
     if((_sndfile = sf_open(name, SFM_READ, &I)) == 0)
         return eErrorOpen;
 
@@ -94,7 +133,9 @@ int SoundFile::open_read(const char* name)
 
     _sampleRate = I.samplerate;
     _nbChannels = I.channels;
-    _nbSamples = I.frames;
+    _seekable = I.seekable;
+    // the length announced by a stream (pipe) header is not reliable
+    _nbSamples = _seekable ? I.frames : 0;
 
     return 0;
 }
@@ -79,8 +79,21 @@ public:
     int getSampleRate(void) const { return _sampleRate; }
     int getNbChannels(void) const { return _nbChannels; }
     uint32_t getNbSamples(void) const { return _nbSamples; }
+    bool isSeekable(void) const { return _seekable; }
 
+    /**
+     * Open a file readable by libsndfile (WAV, AIFF...).
+     * Use "-" as name to read from the standard input: the stream is not seekable and its number of samples is
+     * unknown (getNbSamples() returns 0).
+     */
     int open_read(const char* name);
+
+    /**
+     * Open a headerless PCM file (or the standard input with "-").
+     * \param bitDepth one of EBitDepth, samples are little endian
+     */
+    int open_read_raw(const char* name, int sampleRate, int nbChannels, int bitDepth);
+
     int open_write(const char* name, int audioCodec, int bitDepth, int sampleRate, int nbChannels);
     int close(void);
 
@@ -95,6 +108,7 @@ private:
     };
 
     void reset(void);
+    int open_read(const char* name, SF_INFO& info);
 
     SNDFILE* _sndfile;
     int _readWriteMode;
@@ -103,6 +117,7 @@ private:
     int _sampleRate;
     int _nbChannels;
     uint32_t _nbSamples;
+    bool _seekable;
 };
 }
 }
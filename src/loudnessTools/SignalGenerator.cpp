@@ -0,0 +1,68 @@
+#include "SignalGenerator.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace Loudness
+{
+namespace tools
+{
+
+SignalGenerator::SignalGenerator(const float sampleRate, const unsigned int seed)
+    : _sampleRate(sampleRate)
+    , _phase(0)
+    , _seed(seed)
+{
+    memset(_pinkState, 0, sizeof(_pinkState));
+}
+
+float SignalGenerator::nextRandom()
+{
+    // linear congruential generator (Numerical Recipes), on 32 bits
+    _seed = (_seed * 1664525u + 1013904223u) & 0xFFFFFFFFu;
+    return (float)((double)_seed / 2147483648.0 - 1.0);
+}
+
+void SignalGenerator::generateSine(float* samples, const size_t nbSamples, const float frequency,
+                                   const float amplitude)
+{
+    const double phaseIncrement = frequency / _sampleRate;
+    for(size_t i = 0; i < nbSamples; i++)
+    {
+        samples[i] = amplitude * std::sin(2.0 * M_PI * _phase);
+        _phase += phaseIncrement;
+        _phase -= std::floor(_phase);
+    }
+}
+
+void SignalGenerator::generateWhiteNoise(float* samples, const size_t nbSamples, const float amplitude)
+{
+    for(size_t i = 0; i < nbSamples; i++)
+        samples[i] = amplitude * nextRandom();
+}
+
+void SignalGenerator::generatePinkNoise(float* samples, const size_t nbSamples, const float amplitude)
+{
+    // filter of Paul Kellet (refined method), its gain is about 1 / 0.11
+    float* b = _pinkState;
+    for(size_t i = 0; i < nbSamples; i++)
+    {
+        const float white = nextRandom();
+        b[0] = 0.99886f * b[0] + white * 0.0555179f;
+        b[1] = 0.99332f * b[1] + white * 0.0750759f;
+        b[2] = 0.96900f * b[2] + white * 0.1538520f;
+        b[3] = 0.86650f * b[3] + white * 0.3104856f;
+        b[4] = 0.55000f * b[4] + white * 0.5329522f;
+        b[5] = -0.7616f * b[5] - white * 0.0168980f;
+        const float pink = b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + white * 0.5362f;
+        b[6] = white * 0.115926f;
+        samples[i] = amplitude * 0.11f * pink;
+    }
+}
+
+void SignalGenerator::generateSilence(float* samples, const size_t nbSamples)
+{
+    memset(samples, 0, nbSamples * sizeof(float));
+}
+}
+}
@@ -0,0 +1,59 @@
+#ifndef LOUDNESS_TOOLS_SIGNAL_GENERATOR_HPP_
+#define LOUDNESS_TOOLS_SIGNAL_GENERATOR_HPP_
+
+#include <loudnessCommon/common.hpp>
+
+#include <cstdlib>
+
+namespace Loudness
+{
+namespace tools
+{
+
+/**
+ * Deterministic synthetic signals, to test and benchmark the library without audio files.
+ * The same seed always produces the same samples on every platform.
+ * The signals are continuous across calls: use one generator per channel.
+ **/
+class SignalGenerator
+{
+public:
+    SignalGenerator(const float sampleRate, const unsigned int seed = 1);
+
+    /**
+     * Sinusoid, continuous in phase with the previous calls.
+     * \param frequency in Hz
+     * \param amplitude peak value (linear)
+     */
+    void generateSine(float* samples, const size_t nbSamples, const float frequency, const float amplitude);
+
+    /**
+     * Uniform white noise.
+     * \param amplitude peak value (linear)
+     */
+    void generateWhiteNoise(float* samples, const size_t nbSamples, const float amplitude);
+
+    /**
+     * Pink noise (-3dB per octave), filtered from the white noise.
+     * \param amplitude approximate peak value (linear)
+     */
+    void generatePinkNoise(float* samples, const size_t nbSamples, const float amplitude);
+
+    void generateSilence(float* samples, const size_t nbSamples);
+
+private:
+    // uniform in [-1, 1]
+    float nextRandom();
+
+private:
+    static const size_t PINK_FILTER_SIZE = 7;
+
+    const double _sampleRate;
+    double _phase;                      ///< phase of the sinusoid, in turns
+    unsigned int _seed;                 ///< state of the random generator
+    float _pinkState[PINK_FILTER_SIZE]; ///< states of the pink noise filter
+};
+}
+}
+
+#endif
@@ -28,7 +28,8 @@ WriteXml::~WriteXml()
     xmlFile.close();
 }
 
-void WriteXml::writeResults(const std::string& channelType, Loudness::analyser::LoudnessAnalyser& analyser, const float correctionGain)
+void WriteXml::writeResults(const std::string& channelType, Loudness::analyser::LoudnessAnalyser& analyser, const float correctionGain,
+                            const std::string& programName)
 {
     xmlFile << "<Program filename=\"";
     size_t i;
@@ -40,6 +41,11 @@ void WriteXml::writeResults(const std::string& channelType, Loudness::analyser::
 
     xmlFile << "\" " << printStandard(analyser.getStandard()) << " " << convertValid(analyser.isValidProgram()) << " "
             << "channelsType=\"" << channelType << "\" ";
+    if(!programName.empty())
+    {
+        std::string name = programName;
+        xmlFile << "name=\"" << replaceXmlSpecialCharacters(name) << "\" ";
+    }
     if(std::fabs(1.0 - correctionGain) > 0.001)
     {
         xmlFile << "correctionGain=\"" << getGainAsDb(correctionGain) << "\" ";
@@ -151,12 +157,17 @@ std::string WriteXml::getDate()
 {
     std::string date = "";
     time_t now;
-    struct tm* timeInfo;
+    struct tm timeInfo;
     char buffer[32];
 
     time(&now);
-    timeInfo = localtime(&now);
-    if(std::strftime(buffer, 32, "%a, %d.%m.%Y %H:%M:%S", timeInfo) != 0)
+    // reentrant: reports can be written by several threads
+#ifdef __WINDOWS__
+    localtime_s(&timeInfo, &now);
+#else
+    localtime_r(&now, &timeInfo);
+#endif
+    if(std::strftime(buffer, 32, "%a, %d.%m.%Y %H:%M:%S", &timeInfo) != 0)
         date.assign(buffer);
     return date;
 }
@@ -19,7 +19,16 @@ public:
 
     ~WriteXml();
 
-    void writeResults(const std::string& channelType, Loudness::analyser::LoudnessAnalyser& analyser, const float correctionGain = 1.0);
+    /**
+     * @param programName if not empty, written as the name of the program
+     */
+    void writeResults(const std::string& channelType, Loudness::analyser::LoudnessAnalyser& analyser, const float correctionGain = 1.0,
+                      const std::string& programName = "");
+
+    /**
+     * @brief Set the source files of the next programs.
+     */
+    void setSrcAudioFilenames(const std::vector<std::string>& filenames) { srcAudioFilenames = filenames; }
 
 private:
     void openXMLFile(const std::string& xmlFilename);
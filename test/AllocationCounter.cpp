@@ -0,0 +1,74 @@
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+// no constructor: usable before the static initialization of the program
+thread_local size_t allocationCount = 0;
+
+void* allocate(const std::size_t size)
+{
+    allocationCount++;
+    void* pointer = std::malloc(size ? size : 1);
+    if(!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+}
+
+namespace Loudness
+{
+namespace test
+{
+
+size_t getAllocationCount()
+{
+    return allocationCount;
+}
+}
+}
+
+// replacement of the global allocation functions (the aligned ones of C++17 are not used by the library)
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+    allocationCount++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+    allocationCount++;
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* pointer) throw()
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) throw()
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) throw()
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) throw()
+{
+    std::free(pointer);
+}
@@ -0,0 +1,37 @@
+#ifndef _LOUDNESS_TEST_ALLOCATION_COUNTER_HPP_
+#define _LOUDNESS_TEST_ALLOCATION_COUNTER_HPP_
+
+#include <cstdlib>
+
+namespace Loudness
+{
+namespace test
+{
+
+/**
+ * Number of heap allocations (operator new) of the current thread since its start.
+ * The global operator new is replaced by AllocationCounter.cpp: link it only in the test programs.
+ **/
+size_t getAllocationCount();
+
+/**
+ * Count the heap allocations of the current thread in its scope.
+ * Use it to check that a processing loop is real-time safe after its warm-up.
+ **/
+class ScopedAllocationCounter
+{
+public:
+    ScopedAllocationCounter()
+        : _start(getAllocationCount())
+    {
+    }
+
+    size_t getCount() const { return getAllocationCount() - _start; }
+
+private:
+    const size_t _start;
+};
+}
+}
+
+#endif
@@ -0,0 +1,294 @@
+#include <admLoudnessAnalyser/RiffChunks.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const std::string riffFilename = "adm-riff-chunks.wav";
+
+std::string littleEndian(uint64_t value, const size_t nbBytes)
+{
+    std::string bytes;
+    for(size_t i = 0; i < nbBytes; i++)
+    {
+        bytes += static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+    return bytes;
+}
+
+/**
+ * @brief Chunk with its header, padded to an even size.
+ */
+std::string chunk(const std::string& id, const std::string& data)
+{
+    std::string bytes = id + littleEndian(data.size(), 4) + data;
+    if(data.size() & 1)
+        bytes += '\0';
+    return bytes;
+}
+
+std::string riffFile(const std::string& chunks)
+{
+    return "RIFF" + littleEndian(4 + chunks.size(), 4) + "WAVE" + chunks;
+}
+
+void writeFile(const std::string& filename, const std::string& content)
+{
+    std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(content.data(), content.size());
+}
+
+std::string readFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+uint64_t readLittleEndian(const std::string& bytes, const size_t offset, const size_t nbBytes)
+{
+    uint64_t value = 0;
+    for(size_t i = nbBytes; i > 0; i--)
+        value = (value << 8) | static_cast<unsigned char>(bytes[offset + i - 1]);
+    return value;
+}
+
+std::vector<Loudness::admanalyser::RiffChunk> listRiffChunks(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    return Loudness::admanalyser::listRiffChunks(file);
+}
+
+void expectSameChunks(const std::vector<Loudness::admanalyser::RiffChunk>& expected,
+                      const std::vector<Loudness::admanalyser::RiffChunk>& chunks)
+{
+    ASSERT_EQ(expected.size(), chunks.size());
+    for(size_t i = 0; i < chunks.size(); i++)
+    {
+        EXPECT_EQ(expected[i].id, chunks[i].id);
+        EXPECT_EQ(expected[i].dataOffset, chunks[i].dataOffset);
+        EXPECT_EQ(expected[i].size, chunks[i].size);
+    }
+}
+
+const std::string fmtData(16, 'f');
+const std::string audioData(12, 'd');
+const std::string axmlData = "<ebuCoreMain><coreMetadata/></ebuCoreMain>\n"; // odd size: padded
+}
+
+/**
+ * @brief The chunks are listed with the offset and the size of their data, the padding byte of odd chunks skipped.
+ */
+TEST(RiffChunks, ListChunks)
+{
+    ASSERT_EQ(1u, axmlData.size() & 1);
+    std::istringstream stream(riffFile(chunk("fmt ", fmtData) + chunk("axml", axmlData) + chunk("data", audioData)));
+    const std::vector<Loudness::admanalyser::RiffChunk> chunks = Loudness::admanalyser::listRiffChunks(stream);
+
+    ASSERT_EQ(3u, chunks.size());
+    EXPECT_EQ("fmt ", chunks[0].id);
+    EXPECT_EQ(20u, chunks[0].dataOffset);
+    EXPECT_EQ(fmtData.size(), chunks[0].size);
+    EXPECT_EQ("axml", chunks[1].id);
+    EXPECT_EQ(20u + fmtData.size() + 8, chunks[1].dataOffset);
+    EXPECT_EQ(axmlData.size(), chunks[1].size);
+    EXPECT_EQ("data", chunks[2].id);
+    EXPECT_EQ(chunks[1].dataOffset + axmlData.size() + 1 + 8, chunks[2].dataOffset);
+    EXPECT_EQ(audioData.size(), chunks[2].size);
+
+    std::istringstream notRiff("not a RIFF file");
+    EXPECT_THROW(Loudness::admanalyser::listRiffChunks(notRiff), std::runtime_error);
+}
+
+/**
+ * @brief A shorter XML is padded with spaces in the existing axml chunk: no chunk moves, the audio is untouched.
+ */
+TEST(RiffChunks, OverwriteAxmlChunk)
+{
+    writeFile(riffFilename, riffFile(chunk("fmt ", fmtData) + chunk("axml", axmlData) + chunk("data", audioData)));
+    const std::string before = readFile(riffFilename);
+    const std::vector<Loudness::admanalyser::RiffChunk> chunks = listRiffChunks(riffFilename);
+
+    const std::string xml = "<ebuCoreMain/>";
+    EXPECT_TRUE(Loudness::admanalyser::overwriteAxmlChunk(riffFilename, xml));
+
+    const std::string after = readFile(riffFilename);
+    expectSameChunks(chunks, listRiffChunks(riffFilename));
+    ASSERT_EQ(before.size(), after.size());
+    const size_t axmlOffset = chunks[1].dataOffset;
+    EXPECT_EQ(xml + std::string(axmlData.size() - xml.size(), ' '), after.substr(axmlOffset, axmlData.size()));
+    // header, padding byte and other chunks
+    EXPECT_EQ(before.substr(0, axmlOffset), after.substr(0, axmlOffset));
+    EXPECT_EQ(before.substr(axmlOffset + axmlData.size()), after.substr(axmlOffset + axmlData.size()));
+
+    // a longer XML does not fit: the file is not modified
+    EXPECT_FALSE(Loudness::admanalyser::overwriteAxmlChunk(riffFilename, xml + axmlData));
+    EXPECT_EQ(after, readFile(riffFilename));
+
+    std::remove(riffFilename.c_str());
+}
+
+/**
+ * @brief Without axml chunk, nothing is overwritten.
+ */
+TEST(RiffChunks, OverwriteWithoutAxmlChunk)
+{
+    const std::string content = riffFile(chunk("fmt ", fmtData) + chunk("data", audioData));
+    writeFile(riffFilename, content);
+
+    EXPECT_FALSE(Loudness::admanalyser::overwriteAxmlChunk(riffFilename, "<ebuCoreMain/>"));
+    EXPECT_EQ(content, readFile(riffFilename));
+
+    std::remove(riffFilename.c_str());
+}
+
+/**
+ * @brief An axml chunk in the middle of the file which is too small becomes a JUNK chunk, and the new axml chunk is
+ * appended: the audio is not moved.
+ */
+TEST(RiffChunks, ReplaceAxmlChunkInTheMiddle)
+{
+    writeFile(riffFilename, riffFile(chunk("fmt ", fmtData) + chunk("axml", axmlData) + chunk("data", audioData)));
+    const std::string before = readFile(riffFilename);
+    const std::vector<Loudness::admanalyser::RiffChunk> chunks = listRiffChunks(riffFilename);
+
+    const std::string xml = axmlData + axmlData + "<!-- padded -->"; // odd size: padded
+    EXPECT_TRUE(Loudness::admanalyser::replaceAxmlChunk(riffFilename, xml));
+
+    const std::string after = readFile(riffFilename);
+    const std::vector<Loudness::admanalyser::RiffChunk> newChunks = listRiffChunks(riffFilename);
+    ASSERT_EQ(4u, newChunks.size());
+    expectSameChunks(std::vector<Loudness::admanalyser::RiffChunk>(1, chunks[0]),
+                     std::vector<Loudness::admanalyser::RiffChunk>(1, newChunks[0]));
+    EXPECT_EQ("JUNK", newChunks[1].id);
+    EXPECT_EQ(chunks[1].dataOffset, newChunks[1].dataOffset);
+    EXPECT_EQ(chunks[1].size, newChunks[1].size);
+    expectSameChunks(std::vector<Loudness::admanalyser::RiffChunk>(1, chunks[2]),
+                     std::vector<Loudness::admanalyser::RiffChunk>(1, newChunks[2]));
+    EXPECT_EQ("axml", newChunks[3].id);
+    EXPECT_EQ(before.size() + 8, newChunks[3].dataOffset);
+    EXPECT_EQ(xml.size(), newChunks[3].size);
+
+    EXPECT_EQ(xml, after.substr(newChunks[3].dataOffset, xml.size()));
+    EXPECT_EQ(before.size() + 8 + xml.size() + 1, after.size());
+    EXPECT_EQ(after.size() - 8, readLittleEndian(after, 4, 4));
+    // the audio is not moved
+    const size_t audioChunkOffset = chunks[2].dataOffset - 8;
+    EXPECT_EQ(before.substr(audioChunkOffset), after.substr(audioChunkOffset, before.size() - audioChunkOffset));
+
+    std::remove(riffFilename.c_str());
+}
+
+/**
+ * @brief The last axml chunk of the file is replaced at the same offset, and the file is resized.
+ */
+TEST(RiffChunks, ReplaceLastAxmlChunk)
+{
+    writeFile(riffFilename, riffFile(chunk("fmt ", fmtData) + chunk("data", audioData) + chunk("axml", axmlData)));
+    const std::vector<Loudness::admanalyser::RiffChunk> chunks = listRiffChunks(riffFilename);
+
+    const std::string xml = axmlData + axmlData; // even size
+    EXPECT_TRUE(Loudness::admanalyser::replaceAxmlChunk(riffFilename, xml));
+
+    const std::string after = readFile(riffFilename);
+    const std::vector<Loudness::admanalyser::RiffChunk> newChunks = listRiffChunks(riffFilename);
+    ASSERT_EQ(3u, newChunks.size());
+    EXPECT_EQ("axml", newChunks[2].id);
+    EXPECT_EQ(chunks[2].dataOffset, newChunks[2].dataOffset);
+    EXPECT_EQ(xml.size(), newChunks[2].size);
+
+    EXPECT_EQ(xml, after.substr(newChunks[2].dataOffset));
+    EXPECT_EQ(after.size() - 8, readLittleEndian(after, 4, 4));
+
+    std::remove(riffFilename.c_str());
+}
+
+/**
+ * @brief The size of a RF64 file is read from and written to its ds64 chunk.
+ */
+TEST(RiffChunks, ReplaceAxmlChunkOfRf64File)
+{
+    const uint64_t undefinedSize = 0xFFFFFFFF;
+    const std::string ds64Data = littleEndian(0, 8) + littleEndian(audioData.size(), 8) + littleEndian(3, 8) +
+                                 littleEndian(0, 4);
+    const std::string chunks = chunk("ds64", ds64Data) + chunk("fmt ", fmtData) + "data" +
+                               littleEndian(undefinedSize, 4) + audioData + chunk("axml", axmlData);
+    std::string content = "RF64" + littleEndian(undefinedSize, 4) + "WAVE" + chunks;
+    // RIFF size in ds64
+    content.replace(20, 8, littleEndian(content.size() - 8, 8));
+    writeFile(riffFilename, content);
+
+    const std::vector<Loudness::admanalyser::RiffChunk> before = listRiffChunks(riffFilename);
+    ASSERT_EQ(4u, before.size());
+    EXPECT_EQ("data", before[2].id);
+    EXPECT_EQ(audioData.size(), before[2].size);
+
+    const std::string xml = axmlData + axmlData;
+    EXPECT_TRUE(Loudness::admanalyser::replaceAxmlChunk(riffFilename, xml));
+
+    const std::string after = readFile(riffFilename);
+    const std::vector<Loudness::admanalyser::RiffChunk> newChunks = listRiffChunks(riffFilename);
+    ASSERT_EQ(4u, newChunks.size());
+    EXPECT_EQ("axml", newChunks[3].id);
+    EXPECT_EQ(before[3].dataOffset, newChunks[3].dataOffset);
+    EXPECT_EQ(xml.size(), newChunks[3].size);
+    EXPECT_EQ(xml, after.substr(newChunks[3].dataOffset));
+
+    EXPECT_EQ(undefinedSize, readLittleEndian(after, 4, 4));
+    EXPECT_EQ(after.size() - 8, readLittleEndian(after, 20, 8));
+    EXPECT_EQ(audioData.size(), readLittleEndian(after, 28, 8));
+
+    std::remove(riffFilename.c_str());
+}
+
+/**
+ * @brief A RIFF file cannot grow over 4 GiB: the axml chunk is not replaced and the file is not modified.
+ */
+TEST(RiffChunks, ReplaceAxmlChunkOfRiffFileOver4GiB)
+{
+    // the audio data is a hole of the file, which is not written
+    const uint64_t audioSize = 0xFFFFFF00;
+    const std::string header = chunk("fmt ", fmtData) + chunk("axml", axmlData) + "data" + littleEndian(audioSize, 4);
+    const uint64_t fileSize = 12 + header.size() + audioSize;
+    {
+        std::ofstream file(riffFilename.c_str(), std::ios::binary | std::ios::trunc);
+        const std::string riffHeader = "RIFF" + littleEndian(fileSize - 8, 4) + "WAVE" + header;
+        file.write(riffHeader.data(), riffHeader.size());
+        file.seekp(fileSize - 1);
+        file.put('\0');
+        ASSERT_TRUE(file.good());
+    }
+    const std::vector<Loudness::admanalyser::RiffChunk> chunks = listRiffChunks(riffFilename);
+    ASSERT_EQ(3u, chunks.size());
+
+    // 4 KiB of XML do not fit in the 4 GiB
+    EXPECT_FALSE(Loudness::admanalyser::replaceAxmlChunk(riffFilename, axmlData + std::string(4096, ' ')));
+
+    expectSameChunks(chunks, listRiffChunks(riffFilename));
+    std::ifstream file(riffFilename.c_str(), std::ios::binary | std::ios::ate);
+    EXPECT_EQ(fileSize, static_cast<uint64_t>(file.tellg()));
+    file.seekg(0);
+    std::string riffHeader(12 + header.size(), '\0');
+    file.read(&riffHeader[0], riffHeader.size());
+    EXPECT_EQ("RIFF" + littleEndian(fileSize - 8, 4) + "WAVE" + header, riffHeader);
+    file.close();
+
+    std::remove(riffFilename.c_str());
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
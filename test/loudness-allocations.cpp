@@ -0,0 +1,169 @@
+#include <loudnessAnalyser/LoudnessAnalyser.hpp>
+#include <loudnessCorrector/CorrectBuffer.hpp>
+#include <loudnessCorrector/LookAheadLimiter.hpp>
+#include <loudnessCorrector/PeakLimiter.hpp>
+#include <loudnessTools/SignalGenerator.hpp>
+
+#include "AllocationCounter.hpp"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+/**
+ * Real-time safety of the processing loops: after their warm-up (first block), they must not allocate memory.
+ * This program replaces the global operator new to count the allocations (see AllocationCounter).
+ */
+
+static const size_t sampleRate = 48000;
+static const size_t blockSize = 4800;
+
+/**
+ * @brief Planar programme of loud pink noise, so that the limiters reduce the gain.
+ */
+static std::vector<std::vector<float> > generateProgramme(const size_t nbChannels, const size_t nbSamples)
+{
+    std::vector<std::vector<float> > programme(nbChannels, std::vector<float>(nbSamples));
+    for(size_t channel = 0; channel < nbChannels; channel++)
+    {
+        Loudness::tools::SignalGenerator generator(sampleRate, channel + 1);
+        generator.generatePinkNoise(&programme[channel][0], nbSamples, 1.f);
+    }
+    return programme;
+}
+
+/**
+ * @brief Interlaced copy of a planar programme.
+ */
+static std::vector<float> interlace(const std::vector<std::vector<float> >& programme)
+{
+    const size_t nbChannels = programme.size();
+    std::vector<float> interlaced(nbChannels * programme.at(0).size());
+    for(size_t i = 0; i < programme.at(0).size(); i++)
+    {
+        for(size_t c = 0; c < nbChannels; c++)
+            interlaced[i * nbChannels + c] = programme[c][i];
+    }
+    return interlaced;
+}
+
+TEST(AllocationCounter, CountsAllocations)
+{
+    // a new-expression could be elided by the compiler, not an explicit call
+    Loudness::test::ScopedAllocationCounter counter;
+    void* pointer = ::operator new(16);
+    ::operator delete(pointer);
+    EXPECT_EQ(1u, counter.getCount());
+}
+
+TEST(LoudnessAnalyser, ProcessSamplesDoesNotAllocate)
+{
+    const size_t channelCounts[] = {1, 2, 6};
+    const Loudness::analyser::ETruePeakFilter filters[] = {
+        Loudness::analyser::eTruePeakFilterLegacy, Loudness::analyser::eTruePeakFilterStrict4x,
+        Loudness::analyser::eTruePeakFilterFast4x};
+    const size_t nbSamples = sampleRate * 10;
+
+    for(size_t c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c++)
+    {
+        const size_t nbChannels = channelCounts[c];
+        std::vector<std::vector<float> > programme = generateProgramme(nbChannels, nbSamples);
+        const std::vector<float> interleaved = interlace(programme);
+
+        for(size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++)
+        {
+            for(size_t option = 0; option < 4; option++)
+            {
+                const bool enableOptimization = option & 1;
+                const bool lazyTruePeak = option & 2;
+                SCOPED_TRACE(::testing::Message() << nbChannels << " channels, filter " << filters[f] << ", optimization "
+                                                  << enableOptimization << ", lazy true peak " << lazyTruePeak);
+
+                Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+                Loudness::analyser::LoudnessAnalyser analyser(levels);
+                analyser.setTruePeakFilter(filters[f]);
+                analyser.enableLazyTruePeak(lazyTruePeak);
+                analyser.initAndStart(nbChannels, sampleRate, enableOptimization);
+                analyser.reserve(nbSamples);
+
+                std::vector<float*> data(nbChannels);
+                for(size_t position = 0; position < nbSamples; position += 2 * blockSize)
+                {
+                    for(size_t channel = 0; channel < nbChannels; channel++)
+                        data[channel] = &programme[channel][position];
+
+                    Loudness::test::ScopedAllocationCounter counter;
+                    analyser.processSamples(&data[0], blockSize);
+                    analyser.processInterleavedSamples(&interleaved[(position + blockSize) * nbChannels], blockSize);
+                    if(position)
+                    {
+                        ASSERT_EQ(0u, counter.getCount()) << "at sample " << position;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(Corrector, CorrectBufferDoesNotAllocate)
+{
+    const size_t nbChannels = 2;
+    std::vector<float> interlaced = interlace(generateProgramme(nbChannels, sampleRate * 2));
+    const size_t nbSamples = interlaced.size() / nbChannels;
+
+    std::vector<Loudness::corrector::LookAheadLimiter*> limiters;
+    for(size_t channel = 0; channel < nbChannels; channel++)
+        limiters.push_back(new Loudness::corrector::LookAheadLimiter(10.0, sampleRate, 0.5));
+
+    for(size_t position = 0; position < nbSamples; position += blockSize)
+    {
+        Loudness::test::ScopedAllocationCounter counter;
+        Loudness::corrector::correctBuffer(&interlaced[position * nbChannels], blockSize, nbChannels, 0.5);
+        Loudness::corrector::correctBuffer(limiters, &interlaced[position * nbChannels], blockSize, nbChannels, 2.0);
+        ASSERT_EQ(0u, counter.getCount()) << "at sample " << position;
+    }
+    {
+        Loudness::test::ScopedAllocationCounter counter;
+        Loudness::corrector::getLastData(limiters, &interlaced[0], blockSize, nbChannels, 2.0);
+        EXPECT_EQ(0u, counter.getCount());
+    }
+
+    for(size_t channel = 0; channel < nbChannels; channel++)
+        delete limiters.at(channel);
+}
+
+TEST(Corrector, PeakLimiterDoesNotAllocate)
+{
+    const size_t nbChannels = 6;
+    std::vector<std::vector<float> > programme = generateProgramme(nbChannels, sampleRate * 2);
+    std::vector<float> interlaced = interlace(programme);
+    std::vector<float> interlacedOut(interlaced.size());
+    std::vector<std::vector<float> > planarOut(nbChannels, std::vector<float>(blockSize));
+    const size_t nbSamples = programme.at(0).size();
+
+    Loudness::corrector::PeakLimiter peakLimiter(1.0, 20.0, 0.5, nbChannels, sampleRate);
+    std::vector<const float*> planarIn(nbChannels);
+    std::vector<float*> planarOutPointers(nbChannels);
+    for(size_t position = 0; position < nbSamples; position += blockSize)
+    {
+        for(size_t channel = 0; channel < nbChannels; channel++)
+        {
+            planarIn[channel] = &programme[channel][position];
+            planarOutPointers[channel] = &planarOut[channel][0];
+        }
+
+        Loudness::test::ScopedAllocationCounter counter;
+        peakLimiter.apply(&interlaced[position * nbChannels], &interlacedOut[position * nbChannels], blockSize);
+        peakLimiter.applyPlanar(&planarIn[0], &planarOutPointers[0], blockSize);
+        if(position)
+        {
+            ASSERT_EQ(0u, counter.getCount()) << "at sample " << position;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
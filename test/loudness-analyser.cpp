@@ -1,13 +1,19 @@
 #include <loudnessIO/SoundFile.hpp>
 #include <loudnessIO/ProcessFile.hpp>
 #include <loudnessAnalyser/LoudnessAnalyser.hpp>
+#include <loudnessAnalyser/BasicProcess.hpp>
+#include <loudnessCommon/Trace.hpp>
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <string>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <sstream>
+#include <vector>
 
 #define STR(X) #X
 #define STRINGIFY(X) STR(X)
@@ -310,6 +316,322 @@ TEST_P(CaseLoudnessAnalysis, Test)
     }
 }
 
+/**
+ * @brief An EBU essence to analyse with a given oversampling filter of the TruePeakMeter.
+ */
+struct TruePeakFilterConfiguration
+{
+    Loudness::analyser::ETruePeakFilter _filter;
+    FileConfiguration _file;
+};
+
+/**
+ * @brief Fixture to manage parameterized tests based on TruePeakFilterConfiguration class.
+ */
+class CaseTruePeakFilter : public ::testing::TestWithParam<TruePeakFilterConfiguration>
+{
+public:
+    CaseTruePeakFilter()
+        : _level(Loudness::analyser::LoudnessLevels::Loudness_EBU_R128())
+        , _loudness(_level)
+    {
+    }
+
+    void SetUp()
+    {
+        _configuration = GetParam();
+
+        std::string absoluteFilename = STRINGIFY(EBU_TEST_ESSENCES);
+        absoluteFilename += "/";
+        absoluteFilename += _configuration._file.getFilename();
+        Loudness::io::SoundFile audioFile;
+
+        if(!audioFile.open_read(absoluteFilename.c_str()))
+        {
+            _loudness.setTruePeakFilter(_configuration._filter);
+            Loudness::io::AnalyseFile analyser(_loudness, audioFile);
+            analyser(checkProgress);
+            audioFile.close();
+        }
+    }
+
+public:
+    Loudness::analyser::LoudnessLevels _level; //< The loudness specification used.
+    Loudness::analyser::LoudnessAnalyser _loudness; //< The actual loudness values.
+    TruePeakFilterConfiguration _configuration; //< The filter and the expected loudness values.
+};
+
+/**
+ * @return The true-peak essences, to analyse with each strict filter.
+ */
+std::vector<TruePeakFilterConfiguration> getTruePeakEssencesForStrictFilters()
+{
+    std::vector<TruePeakFilterConfiguration> configurations;
+    const std::vector<FileConfiguration> essences = getEbuEssences();
+    const Loudness::analyser::ETruePeakFilter filters[] = {Loudness::analyser::eTruePeakFilterStrict4x,
+                                                           Loudness::analyser::eTruePeakFilterStrict8x};
+    for(size_t f = 0; f < 2; ++f)
+    {
+        for(size_t i = 0; i < essences.size(); ++i)
+        {
+            FileConfiguration file = essences.at(i);
+            if(std::isnan(file.getTruePeakInDbTP()))
+                continue;
+            TruePeakFilterConfiguration configuration = {filters[f], file};
+            configurations.push_back(configuration);
+        }
+    }
+    return configurations;
+}
+
+INSTANTIATE_TEST_CASE_P(EbuTruePeakEssences, CaseTruePeakFilter, ::testing::ValuesIn(getTruePeakEssencesForStrictFilters()));
+
+/**
+ * @brief Same tolerance as the EBU Tech 3341 (+0.2/-0.4 dB).
+ */
+TEST_P(CaseTruePeakFilter, Test)
+{
+    ASSERT_GT(_loudness.getTruePeakInDbTP(), _configuration._file.getTruePeakInDbTP() - 0.4);
+    ASSERT_LT(_loudness.getTruePeakInDbTP(), _configuration._file.getTruePeakInDbTP() + 0.2);
+}
+
+/**
+ * @brief The processes specialised on the channel layout compute the same values as the generic one.
+ */
+TEST(BasicProcess, SpecialisedLayoutsMatchGenericProcess)
+{
+    const size_t layouts[] = {1, 2, 5, 7};
+    const size_t nbSamples = 4800;
+    for(size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++)
+    {
+        const size_t nbChannels = layouts[l];
+        std::vector<std::vector<float> > samples(nbChannels, std::vector<float>(nbSamples));
+        std::vector<float*> data(nbChannels);
+        for(size_t c = 0; c < nbChannels; c++)
+        {
+            for(size_t i = 0; i < nbSamples; i++)
+                samples[c][i] = 0.5 * std::sin(0.01 * (c + 1) * i);
+            data[c] = &samples[c][0];
+        }
+
+        Loudness::analyser::ChannelsProcess* specialised = Loudness::analyser::createChannelsProcess(nbChannels);
+        Loudness::analyser::BasicProcess<0, float> generic(nbChannels);
+        specialised->init(48000, 192000, Loudness::analyser::eTruePeakFilterLegacy, true);
+        generic.init(48000, 192000, Loudness::analyser::eTruePeakFilterLegacy, true);
+        specialised->reset();
+        generic.reset();
+
+        float specialisedTruePeak = 0;
+        float genericTruePeak = 0;
+        Loudness::analyser::AnalyserStats stats;
+        EXPECT_EQ(generic.detectProcess(&data[0], nbSamples, genericTruePeak, 0.0, false, stats),
+                  specialised->detectProcess(&data[0], nbSamples, specialisedTruePeak, 0.0, false, stats));
+        EXPECT_EQ(genericTruePeak, specialisedTruePeak);
+        delete specialised;
+    }
+}
+
+/**
+ * @brief The channels are weighted by their position in the layout: the LFE of a render is left out, and only the
+ * surround channels at 60 to 120 degrees are weighted at 1.41.
+ */
+TEST(BasicProcess, ChannelWeightsFollowTheLayout)
+{
+    // weight of each channel of the layouts, relative to the left channel
+    const size_t nbSamples = 4800;
+    const float weights7[] = {1.0f, 1.0f, 1.0f, 1.41f, 1.41f, 1.0f, 1.0f};
+    const float weights6[] = {1.0f, 1.0f, 1.0f, 0.0f, 1.41f, 1.41f};
+    const float weights10[] = {1.0f, 1.0f, 1.0f, 0.0f, 1.41f, 1.41f, 1.0f, 1.0f, 1.0f, 1.0f};
+    const std::vector<std::vector<float> > layouts = {std::vector<float>(weights7, weights7 + 7),
+                                                      std::vector<float>(weights6, weights6 + 6),
+                                                      std::vector<float>(weights10, weights10 + 10)};
+    for(size_t l = 0; l < layouts.size(); l++)
+    {
+        const size_t nbChannels = layouts[l].size();
+        const std::vector<float> silence(nbSamples, 0);
+        std::vector<float> tone(nbSamples);
+        for(size_t i = 0; i < nbSamples; i++)
+            tone[i] = 0.5 * std::sin(0.01 * i);
+
+        std::vector<float> powers(nbChannels);
+        for(size_t channel = 0; channel < nbChannels; channel++)
+        {
+            std::vector<float*> data(nbChannels, const_cast<float*>(&silence[0]));
+            data[channel] = &tone[0];
+
+            Loudness::analyser::ChannelsProcess* process = Loudness::analyser::createChannelsProcess(nbChannels);
+            process->init(48000, 192000, Loudness::analyser::eTruePeakFilterLegacy, true);
+            process->reset();
+            float truePeak = 0;
+            Loudness::analyser::AnalyserStats stats;
+            powers[channel] = process->detectProcess(&data[0], nbSamples, truePeak, 0.0, false, stats);
+            delete process;
+        }
+        for(size_t channel = 0; channel < nbChannels; channel++)
+            EXPECT_FLOAT_EQ(layouts[l][channel] * powers[0], powers[channel]) << nbChannels << " channels, channel "
+                                                                               << channel;
+    }
+}
+
+/**
+ * @brief The interleaved samples give the same results as the planar samples, for several block sizes.
+ */
+TEST(LoudnessAnalyser, InterleavedSamplesMatchPlanarSamples)
+{
+    const size_t nbSamples = 48000 * 5;
+    const size_t blockSizes[] = {1024, 2400, 7777};
+
+    for(size_t nbChannels = 1; nbChannels <= 6; nbChannels++)
+    {
+        std::vector<std::vector<float> > planar(nbChannels, std::vector<float>(nbSamples));
+        std::vector<float> interleaved(nbChannels * nbSamples);
+        for(size_t channel = 0; channel < nbChannels; channel++)
+        {
+            for(size_t i = 0; i < nbSamples; i++)
+            {
+                planar[channel][i] = 0.5 * std::sin(0.001 * (channel + 1) * i) * std::sin(0.00003 * i);
+                interleaved[i * nbChannels + channel] = planar[channel][i];
+            }
+        }
+
+        // same blocks: the sums of the fragments are computed in the same order
+        for(size_t b = 0; b < sizeof(blockSizes) / sizeof(blockSizes[0]); b++)
+        {
+            Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+            Loudness::analyser::LoudnessAnalyser planarAnalyser(levels);
+            Loudness::analyser::LoudnessAnalyser interleavedAnalyser(levels);
+            planarAnalyser.initAndStart(nbChannels, 48000);
+            interleavedAnalyser.initAndStart(nbChannels, 48000);
+
+            std::vector<float*> data(nbChannels);
+            for(size_t position = 0; position < nbSamples; position += blockSizes[b])
+            {
+                const size_t blockSize = std::min(blockSizes[b], nbSamples - position);
+                for(size_t channel = 0; channel < nbChannels; channel++)
+                    data[channel] = &planar[channel][position];
+                planarAnalyser.processSamples(&data[0], blockSize);
+                interleavedAnalyser.processInterleavedSamples(&interleaved[position * nbChannels], blockSize);
+            }
+
+            EXPECT_EQ(planarAnalyser.getIntegratedLoudness(), interleavedAnalyser.getIntegratedLoudness());
+            EXPECT_EQ(planarAnalyser.getIntegratedRange(), interleavedAnalyser.getIntegratedRange());
+            EXPECT_EQ(planarAnalyser.getMomentaryLoudness(), interleavedAnalyser.getMomentaryLoudness());
+            EXPECT_EQ(planarAnalyser.getMaxShortTermLoudness(), interleavedAnalyser.getMaxShortTermLoudness());
+            EXPECT_EQ(planarAnalyser.getTruePeakValue(), interleavedAnalyser.getTruePeakValue());
+        }
+    }
+}
+
+/**
+ * @brief The PCM samples are analysed as their float values, scaled to [-1, 1[.
+ */
+TEST(LoudnessAnalyser, InterleavedPcmSamplesMatchFloatSamples)
+{
+    const size_t nbSamples = 48000 * 3;
+    const size_t nbChannels = 2;
+    const size_t blockSize = 1000;
+    const Loudness::analyser::EPcmFormat formats[] = {Loudness::analyser::ePcmFormatS16LE,
+                                                      Loudness::analyser::ePcmFormatS24LE,
+                                                      Loudness::analyser::ePcmFormatS32LE};
+
+    for(size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+    {
+        const size_t nbBytes = formats[f];
+        const double maxValue = std::pow(2.0, 8.0 * nbBytes - 1);
+        std::vector<float> interleaved(nbChannels * nbSamples);
+        std::vector<unsigned char> pcm(nbChannels * nbSamples * nbBytes);
+        for(size_t i = 0; i < nbChannels * nbSamples; i++)
+        {
+            const double sine = 0.9 * std::sin(0.003 * (i % nbChannels + 1) * (i / nbChannels));
+            const long long value = (long long)std::floor(sine * maxValue);
+            interleaved[i] = value / maxValue;
+            for(size_t byte = 0; byte < nbBytes; byte++)
+                pcm[i * nbBytes + byte] = (value >> (8 * byte)) & 0xff;
+        }
+
+        Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+        Loudness::analyser::LoudnessAnalyser floatAnalyser(levels);
+        Loudness::analyser::LoudnessAnalyser pcmAnalyser(levels);
+        floatAnalyser.initAndStart(nbChannels, 48000);
+        pcmAnalyser.initAndStart(nbChannels, 48000);
+        for(size_t position = 0; position < nbSamples; position += blockSize)
+        {
+            floatAnalyser.processInterleavedSamples(&interleaved[position * nbChannels], blockSize);
+            pcmAnalyser.processInterleavedPcmSamples(&pcm[position * nbChannels * nbBytes], blockSize, formats[f]);
+        }
+
+        EXPECT_EQ(floatAnalyser.getIntegratedLoudness(), pcmAnalyser.getIntegratedLoudness());
+        EXPECT_EQ(floatAnalyser.getMaxShortTermLoudness(), pcmAnalyser.getMaxShortTermLoudness());
+        EXPECT_EQ(floatAnalyser.getTruePeakValue(), pcmAnalyser.getTruePeakValue());
+    }
+}
+
+/**
+ * @brief The stats count the samples of each stage, and are reset by initAndStart.
+ */
+TEST(LoudnessAnalyser, StatsCountProcessedSamples)
+{
+    const size_t nbChannels = 2;
+    const size_t nbSamples = 48000;
+    std::vector<float> samples(nbSamples);
+    for(size_t i = 0; i < nbSamples; i++)
+        samples[i] = 0.5 * std::sin(0.01 * i);
+    float* data[nbChannels] = {&samples[0], &samples[0]};
+
+    Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+    Loudness::analyser::LoudnessAnalyser analyser(levels);
+    analyser.initAndStart(nbChannels, 48000);
+    analyser.processSamples(data, nbSamples);
+    analyser.getIntegratedLoudness();
+
+    const Loudness::analyser::AnalyserStats& stats = analyser.getStats();
+#ifndef LOUDNESS_DISABLE_INSTRUMENTATION
+    EXPECT_EQ(1u, stats.process.calls);
+    EXPECT_EQ(nbSamples, stats.process.items);
+    EXPECT_EQ(nbSamples * nbChannels, stats.filter.items);
+    EXPECT_EQ(nbSamples * nbChannels, stats.truePeak.items);
+    EXPECT_EQ(20u, stats.fragments.calls);
+    EXPECT_EQ(1u, stats.histogram.calls);
+#endif
+
+    analyser.initAndStart(nbChannels, 48000);
+    EXPECT_EQ(0u, stats.process.calls);
+    EXPECT_EQ(0u, stats.filter.items);
+}
+
+/**
+ * @brief The spans of the analysis are written to the trace, in the Chrome trace event format.
+ */
+TEST(TraceSession, WritesAnalysisSpans)
+{
+    const std::string traceFilename = "loudness-analyser-trace.json";
+    const size_t nbSamples = 4800;
+    std::vector<float> samples(nbSamples, 0.1f);
+    float* data[2] = {&samples[0], &samples[0]};
+
+    Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+    Loudness::analyser::LoudnessAnalyser analyser(levels);
+    analyser.initAndStart(2, 48000);
+    {
+        Loudness::common::TraceSession traceSession(traceFilename);
+        analyser.processSamples(data, nbSamples);
+        analyser.processSamples(data, nbSamples);
+    }
+
+    std::ifstream traceFile(traceFilename.c_str());
+    ASSERT_TRUE(traceFile.good());
+    std::stringstream trace;
+    trace << traceFile.rdbuf();
+    EXPECT_EQ(0u, trace.str().find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+#ifndef LOUDNESS_DISABLE_INSTRUMENTATION
+    const std::string span = "{\"name\":\"analyse\",\"cat\":\"loudness\",\"ph\":\"X\"";
+    const size_t first = trace.str().find(span);
+    ASSERT_NE(std::string::npos, first);
+    EXPECT_NE(std::string::npos, trace.str().find(span, first + 1));
+#endif
+    std::remove(traceFilename.c_str());
+}
+
 int main(int argc, char** argv)
 {
     // Initialize GTest system
@@ -0,0 +1,147 @@
+#include <loudnessAnalyser/LoudnessAnalyser.hpp>
+#include <loudnessTools/SignalGenerator.hpp>
+
+#include "reference/ReferenceAnalyser.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+/**
+ * Differential tests: the optimized analyser and the frozen reference analyser (see ReferenceAnalyser) process the
+ * same random programmes, and their results must stay within the tolerances of each metric.
+ * The programmes are random but deterministic: a failure is reproduced with the seed of its case.
+ */
+
+/**
+ * @brief Tolerances between the optimized and the reference engines.
+ * The filters and the histograms compute the same values: only the order of the float sums changes, and a loudness
+ * value may fall in the next bin of the histogram (0.01 LU).
+ */
+static const double integratedTolerance = 0.01; // LU
+static const double rangeTolerance = 0.02;      // LU
+static const double momentaryTolerance = 0.001; // LU
+static const double shortTermTolerance = 0.001; // LU
+static const double truePeakTolerance = 0.0001; // dB
+
+static const size_t nbCases = 16;
+
+/**
+ * @brief Deterministic random numbers: the sequence of std::mt19937 is the same on every platform.
+ */
+class Random
+{
+public:
+    Random(const unsigned int seed)
+        : _generator(seed)
+    {
+    }
+
+    // uniform in [0, max[
+    size_t next(const size_t max) { return (size_t)(_generator() / 4294967296.0 * max); }
+
+private:
+    std::mt19937 _generator;
+};
+
+/**
+ * @brief Random programme: segments of pink noise, sine, white noise and digital silence, with random levels.
+ */
+static std::vector<std::vector<float> > generateProgramme(Random& random, const size_t nbChannels,
+                                                          const float sampleRate, const size_t nbSamples)
+{
+    std::vector<std::vector<float> > programme(nbChannels, std::vector<float>(nbSamples));
+    for(size_t channel = 0; channel < nbChannels; channel++)
+    {
+        Loudness::tools::SignalGenerator generator(sampleRate, random.next(1000) + 1);
+        size_t position = 0;
+        while(position < nbSamples)
+        {
+            const size_t length = std::min(nbSamples - position, (size_t)(sampleRate * (0.1 + random.next(40) / 10.0)));
+            const float amplitude = std::pow(10.0, -(double)random.next(600) / 200.0); // 0 to -60 dBFS
+            float* samples = &programme[channel][position];
+            switch(random.next(5))
+            {
+                case 0:
+                    generator.generateSilence(samples, length);
+                    break;
+                case 1:
+                    generator.generateSine(samples, length, 20.0 + random.next(15000), amplitude);
+                    break;
+                case 2:
+                    generator.generateWhiteNoise(samples, length, amplitude);
+                    break;
+                default:
+                    generator.generatePinkNoise(samples, length, amplitude);
+                    break;
+            }
+            position += length;
+        }
+    }
+    return programme;
+}
+
+/**
+ * @brief Random sample rates, channel counts, block sizes and options of the optimized engine.
+ */
+TEST(Differential, OptimizedEngineMatchesReference)
+{
+    const float sampleRates[] = {32000, 44100, 48000, 88200, 96000};
+    const size_t channelCounts[] = {1, 2, 3, 5, 6, 7, 8};
+
+    for(size_t testCase = 0; testCase < nbCases; testCase++)
+    {
+        const unsigned int seed = 1000 + testCase;
+        Random random(seed);
+        const float sampleRate = sampleRates[random.next(5)];
+        const size_t nbChannels = channelCounts[random.next(7)];
+        const size_t nbSamples = sampleRate * (4 + random.next(6)); // 4 to 9 seconds
+        const bool enableOptimization = random.next(2);
+        const bool lazyTruePeak = random.next(2);
+
+        std::ostringstream description;
+        description << "seed " << seed << ": " << nbChannels << " channels at " << sampleRate << " Hz, "
+                    << nbSamples / sampleRate << " s, optimization " << enableOptimization << ", lazy true peak "
+                    << lazyTruePeak;
+        SCOPED_TRACE(description.str());
+
+        const std::vector<std::vector<float> > programme = generateProgramme(random, nbChannels, sampleRate, nbSamples);
+
+        Loudness::analyser::LoudnessLevels levels = Loudness::analyser::LoudnessLevels::Loudness_EBU_R128();
+        Loudness::analyser::LoudnessAnalyser analyser(levels);
+        analyser.enableLazyTruePeak(lazyTruePeak);
+        analyser.initAndStart(nbChannels, sampleRate, enableOptimization);
+
+        Loudness::reference::ReferenceAnalyser reference(nbChannels, sampleRate);
+
+        // same samples, in blocks of random sizes for the optimized engine
+        std::vector<float*> data(nbChannels);
+        size_t position = 0;
+        while(position < nbSamples)
+        {
+            const size_t blockSize = std::min(nbSamples - position, 1 + random.next(random.next(2) ? 64 : 16384));
+            for(size_t channel = 0; channel < nbChannels; channel++)
+                data[channel] = const_cast<float*>(&programme[channel][position]);
+            analyser.processSamples(&data[0], blockSize);
+            position += blockSize;
+        }
+        for(size_t channel = 0; channel < nbChannels; channel++)
+            data[channel] = const_cast<float*>(&programme[channel][0]);
+        reference.processSamples(&data[0], nbSamples);
+
+        EXPECT_NEAR(reference.getIntegratedLoudness(), analyser.getIntegratedLoudness(), integratedTolerance);
+        EXPECT_NEAR(reference.getIntegratedRange(), analyser.getIntegratedRange(), rangeTolerance);
+        EXPECT_NEAR(reference.getMaxMomentaryLoudness(), analyser.getMomentaryLoudness(), momentaryTolerance);
+        EXPECT_NEAR(reference.getMaxShortTermLoudness(), analyser.getMaxShortTermLoudness(), shortTermTolerance);
+        EXPECT_NEAR(20.0 * std::log10(reference.getTruePeakValue()), analyser.getTruePeakInDbTP(), truePeakTolerance);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,266 @@
+#include "ReferenceAnalyser.hpp"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <algorithm>
+
+namespace Loudness
+{
+namespace reference
+{
+
+// K-weighting filters (ITU-R BS.1770)
+#define FC_PRE_FILTER 1681.974450955533
+#define VH_PRE_FILTER 1.584864701130855
+#define VB_PRE_FILTER 1.258720930232562
+#define VL_PRE_FILTER 1.0
+#define Q_PRE_FILTER 0.7071752369554196
+
+#define FC_RLB_FILTER 38.13547087602444
+#define VH_RLB_FILTER 1.0
+#define VB_RLB_FILTER 0.0
+#define VL_RLB_FILTER 0.0
+#define Q_RLB_FILTER 0.5003270373238773
+
+#define LOUD_CONSTANT -0.691f
+
+// histograms of the loudness values (in LUFS)
+#define HISTOGRAM_MIN -70.0f
+#define HISTOGRAM_MAX 5.0f
+#define HISTOGRAM_STEP 0.01f
+
+static const size_t histogramSize = ((HISTOGRAM_MAX - HISTOGRAM_MIN) / HISTOGRAM_STEP) + 1;
+
+// weight of a channel (ITU-R BS.1770-4), the layout is given by the number of channels
+static float channelWeight(const size_t nbChannels, const size_t channel)
+{
+    // L, R, C, Ls, Rs, or 7.0: L, R, C, Lss, Rss, Lrs, Rrs
+    static const float surroundWeights[] = {1.0f, 1.0f, 1.0f, 1.41f, 1.41f, 1.0f, 1.0f};
+    // ITU-R BS.2051 renders: L, R, C, LFE, surround channels of the middle layer, then rear and upper channels
+    static const float renderWeights[] = {1.0f, 1.0f, 1.0f, 0.0f, 1.41f, 1.41f};
+
+    if(nbChannels == 1)
+        return 2.0f;
+    if(nbChannels <= 5 || nbChannels == 7)
+        return surroundWeights[channel];
+    return channel < 6 ? renderWeights[channel] : 1.0f;
+}
+
+ReferenceAnalyser::Measure::Measure(const size_t windowSize, const size_t histogramPeriod)
+    : windowSize(windowSize)
+    , histogramPeriod(histogramPeriod)
+    , fragments(windowSize, 0.f)
+    , fragmentIndex(0)
+    , rollingSum(0.f)
+    , numberOfFragments(0)
+    , maxLoudness(-200.f)
+    , histogram(histogramSize, 0)
+{
+}
+
+void ReferenceAnalyser::Measure::addFragment(const float power)
+{
+    // as boost::accumulators::rolling_sum: remove the oldest fragment, then add the new one
+    rollingSum -= fragments[fragmentIndex];
+    rollingSum += power;
+    fragments[fragmentIndex] = power;
+    fragmentIndex = (fragmentIndex + 1) % windowSize;
+
+    const float loudness = LOUD_CONSTANT + 10.0 * std::log10(rollingSum / (double)windowSize);
+
+    if(++numberOfFragments == histogramPeriod)
+    {
+        if(loudness > HISTOGRAM_MIN && loudness < HISTOGRAM_MAX)
+            histogram.at(std::floor(convertDbToIndex(loudness)))++;
+        numberOfFragments = 0;
+    }
+    maxLoudness = std::max(maxLoudness, loudness);
+}
+
+ReferenceAnalyser::ReferenceAnalyser(const size_t nbChannels, const float frequencySampling,
+                                     const float absoluteThreshold, const float relativeThreshold)
+    : _nbChannels(nbChannels)
+    , _absoluteThreshold(absoluteThreshold)
+    , _relativeThreshold(relativeThreshold)
+    , _filters(nbChannels)
+    , _truePeaks(nbChannels)
+    , _truePeakValue(0)
+    , _fragmentSize((int)frequencySampling / 20)
+    , _fragmentCount(_fragmentSize)
+    , _fragmentPower(1e-30f)
+    , _momentary(8, 2)
+    , _shortTerm(60, 10)
+{
+    const double preOmega = std::tan(M_PI * FC_PRE_FILTER / frequencySampling);
+    const double preOmega2 = preOmega * preOmega;
+    const double preDenominator = preOmega2 + preOmega / Q_PRE_FILTER + 1;
+    _preA1 = 2 * (preOmega2 - 1) / preDenominator;
+    _preA2 = (preOmega2 - preOmega / Q_PRE_FILTER + 1) / preDenominator;
+    _preB0 = (VL_PRE_FILTER * preOmega2 + VB_PRE_FILTER * preOmega / Q_PRE_FILTER + VH_PRE_FILTER) / preDenominator;
+    _preB1 = 2 * (VL_PRE_FILTER * preOmega2 - VH_PRE_FILTER) / preDenominator;
+    _preB2 = (VL_PRE_FILTER * preOmega2 - VB_PRE_FILTER * preOmega / Q_PRE_FILTER + VH_PRE_FILTER) / preDenominator;
+
+    const double rlbOmega = std::tan(M_PI * FC_RLB_FILTER / frequencySampling);
+    const double rlbOmega2 = rlbOmega * rlbOmega;
+    const double rlbDenominator = rlbOmega2 + rlbOmega / Q_RLB_FILTER + 1;
+    const double rlbNormalizedDenominator =
+        VL_RLB_FILTER * rlbOmega2 + VB_RLB_FILTER * rlbOmega / Q_RLB_FILTER + VH_RLB_FILTER;
+    _rlbA1 = 2 * (rlbOmega2 - 1) / rlbDenominator;
+    _rlbA2 = (rlbOmega2 - rlbOmega / Q_RLB_FILTER + 1) / rlbDenominator;
+    _rlbB0 = 1.0;
+    _rlbB1 = 2 * (VL_RLB_FILTER * rlbOmega2 - VH_RLB_FILTER) / rlbNormalizedDenominator;
+    _rlbB2 = (VL_RLB_FILTER * rlbOmega2 - VB_RLB_FILTER * rlbOmega / Q_RLB_FILTER + VH_RLB_FILTER) /
+             rlbNormalizedDenominator;
+
+    for(size_t channel = 0; channel < _nbChannels; channel++)
+        _filters[channel].z1 = _filters[channel].z2 = _filters[channel].z3 = _filters[channel].z4 = 0;
+
+    // sinc interpolation to 192kHz, symmetric around its center
+    _factor = 192000.0 / frequencySampling;
+    for(int i = TRUE_PEAK_FILTER_SIZE / 2; i > 0; --i)
+        _truePeakCoefficients.push_back(_factor * std::sin(M_PI * i / _factor) / (M_PI * i));
+    _truePeakCoefficients.push_back(1.0);
+    for(int i = 1; i <= TRUE_PEAK_FILTER_SIZE / 2; ++i)
+        _truePeakCoefficients.push_back(_factor * std::sin(M_PI * i / _factor) / (M_PI * i));
+
+    // the taps are read with an integer step
+    size_t historySize = 0;
+    for(int iter = 0; iter < TRUE_PEAK_FILTER_SIZE; iter += _factor)
+        historySize++;
+    for(size_t channel = 0; channel < _nbChannels; channel++)
+        _truePeaks[channel].history.assign(historySize, 0.f);
+}
+
+float ReferenceAnalyser::filterSample(Filter& filter, const float sample) const
+{
+    const double x = sample - _preA1 * filter.z1 - _preA2 * filter.z2;
+    const double y = _preB0 * x + _preB1 * filter.z1 + _preB2 * filter.z2 - _rlbA1 * filter.z3 - _rlbA2 * filter.z4;
+    const float filtered = _rlbB0 * y + _rlbB1 * filter.z3 + _rlbB2 * filter.z4;
+
+    filter.z2 = filter.z1;
+    filter.z1 = x;
+    filter.z4 = filter.z3;
+    filter.z3 = y;
+    return filtered;
+}
+
+void ReferenceAnalyser::processTruePeakSample(TruePeak& truePeak, const float sample)
+{
+    std::vector<float>& history = truePeak.history;
+    history.erase(history.begin());
+    history.push_back(sample);
+
+    for(int interSampleIdx = 0; interSampleIdx < _factor; interSampleIdx++)
+    {
+        double value = 0.0;
+        int historySampleIndex = 0;
+        for(int iter = 0; iter + interSampleIdx < TRUE_PEAK_FILTER_SIZE; iter += _factor, historySampleIndex++)
+            value += _truePeakCoefficients.at(interSampleIdx + iter) * history.at(history.size() - historySampleIndex - 1);
+        _truePeakValue = std::max(_truePeakValue, std::abs(value));
+    }
+    _truePeakValue = std::max(_truePeakValue, (double)std::abs(sample));
+}
+
+void ReferenceAnalyser::processSamples(const float* const* samplesData, const size_t nbSamples)
+{
+    for(size_t sample = 0; sample < nbSamples; sample++)
+    {
+        for(size_t channel = 0; channel < _nbChannels; channel++)
+        {
+            const float gain = channelWeight(_nbChannels, channel);
+            const float filtered = filterSample(_filters[channel], samplesData[channel][sample]);
+            _fragmentPower += gain * filtered * filtered;
+            processTruePeakSample(_truePeaks[channel], samplesData[channel][sample]);
+        }
+
+        if(--_fragmentCount == 0)
+        {
+            _momentary.addFragment(_fragmentPower / _fragmentSize);
+            _shortTerm.addFragment(_fragmentPower / _fragmentSize);
+            _fragmentCount = _fragmentSize;
+            _fragmentPower = 1e-30f;
+        }
+    }
+}
+
+double ReferenceAnalyser::getIntegratedLoudness()
+{
+    const float threshold = integratedValue(_momentary.histogram, _absoluteThreshold, 5.0) + _relativeThreshold;
+    return integratedValue(_momentary.histogram, threshold, 5.0);
+}
+
+double ReferenceAnalyser::getIntegratedRange()
+{
+    const float threshold = integratedValue(_shortTerm.histogram, _absoluteThreshold, 5.0) - 20.f;
+    return foundMaxPercentageFrom(_shortTerm.histogram, 95.0, threshold, 5.0) -
+           foundMinPercentageFrom(_shortTerm.histogram, 10.0, threshold, 5.0);
+}
+
+float ReferenceAnalyser::integratedValue(const std::vector<int>& histogram, const float fromValue,
+                                         const float toValue)
+{
+    const int fromIndex = std::max(0, convertDbToIndex(fromValue));
+    const int toIndex = std::min((int)histogram.size(), convertDbToIndex(toValue));
+
+    float sum = 0.0;
+    int countSegment = 0;
+    for(int i = fromIndex; i < toIndex; i++)
+    {
+        sum += histogram.at(i) * std::pow(10.f, convertIndexToDb(i) / 10.f);
+        countSegment += histogram.at(i);
+    }
+    return 10.0 * std::log10(sum / countSegment);
+}
+
+float ReferenceAnalyser::foundMinPercentageFrom(const std::vector<int>& histogram, const float percentile,
+                                                const float fromValue, const float toValue)
+{
+    const int fromIndex = std::max(0, convertDbToIndex(fromValue));
+    const int toIndex = std::min((int)histogram.size(), convertDbToIndex(toValue));
+
+    int elements = 0;
+    for(int i = fromIndex; i < toIndex; i++)
+        elements += histogram.at(i);
+    const int segment = 0.01f * percentile * elements;
+
+    int foundSegment = 0;
+    int correctIndex = 0;
+    for(int i = fromIndex; i < toIndex; i++)
+    {
+        foundSegment += histogram.at(i);
+        if(foundSegment > segment)
+            break;
+        correctIndex = i;
+    }
+    return convertIndexToDb(correctIndex);
+}
+
+float ReferenceAnalyser::foundMaxPercentageFrom(const std::vector<int>& histogram, const float percentile,
+                                                const float fromValue, const float toValue)
+{
+    const int fromIndex = std::max(0, convertDbToIndex(fromValue));
+    const int toIndex = std::min((int)histogram.size(), convertDbToIndex(toValue));
+
+    int elements = 0;
+    for(int i = fromIndex; i < toIndex; i++)
+        elements += histogram.at(i);
+    const int segment = 0.01f * percentile * elements;
+
+    int foundSegment = 0;
+    int i = fromIndex;
+    for(; i < toIndex && foundSegment < segment; i++)
+        foundSegment += histogram.at(i);
+    return convertIndexToDb(i);
+}
+
+int ReferenceAnalyser::convertDbToIndex(const float value)
+{
+    return (value - HISTOGRAM_MIN) * histogramSize / (HISTOGRAM_MAX - HISTOGRAM_MIN);
+}
+
+float ReferenceAnalyser::convertIndexToDb(const int index)
+{
+    return 1.f * index * (HISTOGRAM_MAX - HISTOGRAM_MIN) / (1.0 * histogramSize) + HISTOGRAM_MIN;
+}
+}
+}
@@ -0,0 +1,105 @@
+#ifndef _LOUDNESS_TEST_REFERENCE_ANALYSER_HPP_
+#define _LOUDNESS_TEST_REFERENCE_ANALYSER_HPP_
+
+#include <cstdlib>
+#include <vector>
+
+namespace Loudness
+{
+namespace reference
+{
+
+/**
+ * Frozen scalar implementation of the loudness analysis, to check the optimized engine against it.
+ * It computes sample by sample, as the analyser did before its optimizations (no SIMD, no block processing,
+ * no lazy evaluation, no silence detection, no layout specialisation), with the same precision and the same
+ * histograms.
+ * Do not optimize this code: a faster kernel of the library is validated by comparing its results to these ones.
+ **/
+class ReferenceAnalyser
+{
+public:
+    ReferenceAnalyser(const size_t nbChannels, const float frequencySampling, const float absoluteThreshold = -70.0,
+                      const float relativeThreshold = -10.0);
+
+    /**
+     * \param samplesData data for each channel ( data[channel][sampleTime] )
+     */
+    void processSamples(const float* const* samplesData, const size_t nbSamples);
+
+    double getIntegratedLoudness();
+    double getIntegratedRange();
+    double getMaxMomentaryLoudness() const { return _momentary.maxLoudness; }
+    double getMaxShortTermLoudness() const { return _shortTerm.maxLoudness; }
+    double getTruePeakValue() const { return _truePeakValue; }
+
+private:
+    // K-weighting pre-filter and RLB filter of a channel
+    struct Filter
+    {
+        float z1, z2, z3, z4;
+    };
+
+    // legacy TruePeak oversampling (sinc filter of 125 taps) of a channel
+    struct TruePeak
+    {
+        std::vector<float> history;
+    };
+
+    // loudness on a rolling window of fragments of 50ms, and the histogram of its values
+    struct Measure
+    {
+        Measure(const size_t windowSize, const size_t histogramPeriod);
+        void addFragment(const float power);
+
+        const size_t windowSize;      ///< number of fragments of the window
+        const size_t histogramPeriod; ///< number of fragments between two values of the histogram
+        std::vector<float> fragments; ///< last fragments of the window
+        size_t fragmentIndex;
+        float rollingSum;
+        size_t numberOfFragments;
+        float maxLoudness;
+        std::vector<int> histogram;
+    };
+
+    float filterSample(Filter& filter, const float sample) const;
+    void processTruePeakSample(TruePeak& truePeak, const float sample);
+
+    static float integratedValue(const std::vector<int>& histogram, const float fromValue, const float toValue);
+    static float foundMinPercentageFrom(const std::vector<int>& histogram, const float percentile,
+                                        const float fromValue, const float toValue);
+    static float foundMaxPercentageFrom(const std::vector<int>& histogram, const float percentile,
+                                        const float fromValue, const float toValue);
+    static int convertDbToIndex(const float value);
+    static float convertIndexToDb(const int index);
+
+private:
+    static const int TRUE_PEAK_FILTER_SIZE = 125;
+
+    const size_t _nbChannels;
+    const float _absoluteThreshold;
+    const float _relativeThreshold;
+
+    // filter coefficients
+    double _preA1, _preA2, _preB0, _preB1, _preB2;
+    double _rlbA1, _rlbA2, _rlbB0, _rlbB1, _rlbB2;
+    std::vector<Filter> _filters;
+
+    // TruePeak
+    double _factor;
+    std::vector<float> _truePeakCoefficients;
+    std::vector<TruePeak> _truePeaks;
+    double _truePeakValue;
+
+    // fragments
+    size_t _fragmentSize;
+    size_t _fragmentCount;
+    float _fragmentPower;
+
+    Measure _momentary;
+    Measure _shortTerm;
+};
+}
+}
+
+#endif
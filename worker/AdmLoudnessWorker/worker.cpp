@@ -2,8 +2,38 @@
 #include "worker.hpp"
 
 #include <admLoudnessAnalyser/AdmLoudnessAnalyser.hpp>
+#include <loudnessCommon/ProgressToken.hpp>
 #include <adm_engine/parser.hpp>
 
+#include <map>
+#include <mutex>
+
+namespace {
+
+// progress tokens of the running jobs, to cancel them from another thread
+std::mutex runningJobsMutex;
+std::map<Handler, Loudness::common::ProgressToken*> runningJobs;
+
+// registers the token of a job while it is running
+class RunningJob {
+public:
+  RunningJob(Handler handler, Loudness::common::ProgressToken& token)
+    : _handler(handler) {
+    std::lock_guard<std::mutex> lock(runningJobsMutex);
+    runningJobs[_handler] = &token;
+  }
+
+  ~RunningJob() {
+    std::lock_guard<std::mutex> lock(runningJobsMutex);
+    runningJobs.erase(_handler);
+  }
+
+private:
+  Handler _handler;
+};
+
+}
+
 std::map<std::string, float> parseElementGains(const std::string& elementGainsStr, const Logger& logger) {
   std::map<std::string, float> elementGains;
   const size_t arrayInPos = elementGainsStr.find("[");
@@ -105,11 +135,23 @@ int analyse(const std::string& inputFilePath,
 
   try {
     Loudness::admanalyser::AdmLoudnessAnalyser analyser(inputFilePath, outputLayout, elementGains, outputPath, elementIdToRender);
+    // the messages of this job go to its logger, not to the standard output shared by the concurrent jobs
+    analyser.setLogger([&logger](const std::string& level, const std::string& message) {
+      logger(level.c_str(), message.c_str());
+    });
+
+    // the progress of the processing goes from 5 to 100%
+    Loudness::common::ProgressToken token([&handler, &progress_callback](const int progress) {
+      progress_callback(handler, 5 + progress * 95 / 100);
+    });
+    RunningJob runningJob(handler, token);
+    analyser.setProgressToken(&token);
+
     const std::shared_ptr<adm::Document> admDocument = analyser.process(displayValues, enableCorrection, enableLimiter);
     const std::string admDocumentAsString = admengine::getAdmDocumentAsString(admDocument);
 
     const std::vector<std::string> processOutputPaths = analyser.getOutputPaths();
-    output_paths[0] = (const char **)malloc(sizeof(int) * processOutputPaths.size() + 1);
+    output_paths[0] = (const char **)malloc(sizeof(const char*) * (processOutputPaths.size() + 1));
     for(size_t i = 0; i < processOutputPaths.size(); i++) {
       set_str_on_ptr(&output_paths[0][i], processOutputPaths[i].c_str());
     }
@@ -127,6 +169,16 @@ int analyse(const std::string& inputFilePath,
   return 0;
 }
 
+int cancel(Handler handler) {
+  std::lock_guard<std::mutex> lock(runningJobsMutex);
+  std::map<Handler, Loudness::common::ProgressToken*>::iterator job = runningJobs.find(handler);
+  if(job == runningJobs.end()) {
+    return 1;
+  }
+  job->second->cancel();
+  return 0;
+}
+
 char* get_name() {
 	return (char*)"ADM Loudness Worker";
 }
@@ -100,6 +100,14 @@ int process(
     const char*** output_paths
   );
 
+/**
+ * Cancel a running job: its process function stops at the next block of audio and returns an error.
+ * It can be called by any thread.
+ * @param handler    the job & channel handler given to process
+ * @return 0 if the job is running, 1 otherwise
+ */
+int cancel(Handler handler);
+
 /**
  * Set the C string to the pointer
  * @param message  Pointer on the const char*